@@ -155,6 +155,25 @@ bool LoadObj(std::vector<shape_t> &shapes,       // [output]
              std::istream &inStream, MaterialReader &readMatFn,
              bool triangulate = true);
 
+/// Loads .obj from a file like the first LoadObj(), but memory-maps it and
+/// tokenizes newline-aligned chunks on `num_threads` worker threads
+/// (0 = hardware concurrency). Statements are merged back in file order, so
+/// the resulting shapes are identical to the serial loader's.
+bool LoadObjParallel(std::vector<shape_t> &shapes,       // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err,                   // [output]
+                     const char *filename, const char *mtl_basepath = NULL,
+                     bool triangulate = true, int num_threads = 0);
+
+/// Same as the first LoadObj(), but face corners are deduplicated through
+/// the std::map the loader used before VertexCache. Only meant as a baseline
+/// for benchmarks; the resulting shapes are identical.
+bool LoadObjMapCache(std::vector<shape_t> &shapes,       // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err,                   // [output]
+                     const char *filename, const char *mtl_basepath = NULL,
+                     bool triangulate = true);
+
 /// Loads materials into std::map
 void LoadMtl(std::map<std::string, int> &material_map, // [output]
              std::vector<material_t> &materials,       // [output]
@@ -164,17 +183,28 @@ void LoadMtl(std::map<std::string, int> &material_map, // [output]
 #ifdef TINYOBJLOADER_IMPLEMENTATION
 #include <cassert>
 #include <cctype>
+#include <climits>
 #include <cmath>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "tiny_obj_loader.h"
 
 namespace tinyobj
@@ -203,18 +233,152 @@ struct tag_sizes
     int num_strings;
 };
 
-// for std::map
-static inline bool operator<(const vertex_index &a, const vertex_index &b)
+// Open-addressing (linear probing) hash map from a (v, vt, vn) triple to the
+// output vertex index. Replaces std::map so each face corner costs O(1).
+class VertexCache
 {
-    if (a.v_idx != b.v_idx)
-        return (a.v_idx < b.v_idx);
-    if (a.vn_idx != b.vn_idx)
-        return (a.vn_idx < b.vn_idx);
-    if (a.vt_idx != b.vt_idx)
-        return (a.vt_idx < b.vt_idx);
+public:
+    VertexCache() : count_(0) {}
 
-    return false;
-}
+    // Returns the cached index or inserts `idx` and returns it.
+    // `inserted` tells the caller whether the triple was new.
+    unsigned int findOrInsert(const vertex_index &key, unsigned int idx,
+                              bool &inserted)
+    {
+        if ((count_ + 1) * 2 > slots_.size())
+        {
+            grow();
+        }
+
+        size_t mask = slots_.size() - 1;
+        size_t pos = hash(key) & mask;
+        for (;;)
+        {
+            slot &s = slots_[pos];
+            if (s.value == kEmpty)
+            {
+                s.v = key.v_idx;
+                s.vt = key.vt_idx;
+                s.vn = key.vn_idx;
+                s.value = idx;
+                count_++;
+                inserted = true;
+                return idx;
+            }
+            if (s.v == key.v_idx && s.vt == key.vt_idx && s.vn == key.vn_idx)
+            {
+                inserted = false;
+                return s.value;
+            }
+            pos = (pos + 1) & mask;
+        }
+    }
+
+    void clear()
+    {
+        if (count_ == 0)
+            return;
+        for (size_t i = 0; i < slots_.size(); i++)
+        {
+            slots_[i].value = kEmpty;
+        }
+        count_ = 0;
+    }
+
+private:
+    static const unsigned int kEmpty = 0xFFFFFFFFu;
+
+    struct slot
+    {
+        int v, vt, vn;
+        unsigned int value;
+    };
+
+    static size_t hash(const vertex_index &key)
+    {
+        // Pack the triple into 64 bits and mix (splitmix64 finalizer)
+        unsigned long long h =
+            static_cast<unsigned long long>(static_cast<unsigned int>(key.v_idx));
+        h = h * 0x9E3779B97F4A7C15ULL +
+            static_cast<unsigned int>(key.vt_idx);
+        h = h * 0x9E3779B97F4A7C15ULL +
+            static_cast<unsigned int>(key.vn_idx);
+        h ^= h >> 30;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 27;
+        h *= 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return static_cast<size_t>(h);
+    }
+
+    void grow()
+    {
+        std::vector<slot> old;
+        old.swap(slots_);
+        slot empty = {0, 0, 0, kEmpty};
+        slots_.assign(old.empty() ? 1024 : old.size() * 2, empty);
+        count_ = 0;
+
+        size_t mask = slots_.size() - 1;
+        for (size_t i = 0; i < old.size(); i++)
+        {
+            if (old[i].value == kEmpty)
+                continue;
+            size_t pos = hash(vertex_index(old[i].v, old[i].vt, old[i].vn)) & mask;
+            while (slots_[pos].value != kEmpty)
+            {
+                pos = (pos + 1) & mask;
+            }
+            slots_[pos] = old[i];
+            count_++;
+        }
+    }
+
+    std::vector<slot> slots_;
+    size_t count_;
+};
+
+// The std::map keyed cache VertexCache replaced, with the same interface.
+// Only used by LoadObjMapCache(), as a baseline for benchmarks.
+class MapVertexCache
+{
+public:
+    unsigned int findOrInsert(const vertex_index &key, unsigned int idx,
+                              bool &inserted)
+    {
+        // find, then insert on a miss, as updateVertex used to
+        std::map<vertex_index, unsigned int, less>::iterator it =
+            map_.find(key);
+        if (it != map_.end())
+        {
+            inserted = false;
+            return it->second;
+        }
+        map_[key] = idx;
+        inserted = true;
+        return idx;
+    }
+
+    void clear() { map_.clear(); }
+
+private:
+    struct less
+    {
+        bool operator()(const vertex_index &a, const vertex_index &b) const
+        {
+            if (a.v_idx != b.v_idx)
+                return (a.v_idx < b.v_idx);
+            if (a.vn_idx != b.vn_idx)
+                return (a.vn_idx < b.vn_idx);
+            if (a.vt_idx != b.vt_idx)
+                return (a.vt_idx < b.vt_idx);
+
+            return false;
+        }
+    };
+
+    std::map<vertex_index, unsigned int, less> map_;
+};
 
 struct obj_shape
 {
@@ -501,21 +665,22 @@ static vertex_index parseTriple(const char *&token, int vsize, int vnsize,
     return vi;
 }
 
+template <typename Cache>
 static unsigned int
-updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
-             std::vector<float> &positions, std::vector<float> &normals,
-             std::vector<float> &texcoords,
+updateVertex(Cache &vertexCache, std::vector<float> &positions,
+             std::vector<float> &normals, std::vector<float> &texcoords,
              const std::vector<float> &in_positions,
              const std::vector<float> &in_normals,
              const std::vector<float> &in_texcoords, const vertex_index &i)
 {
-    const std::map<vertex_index, unsigned int>::iterator it =
-        vertexCache.find(i);
+    bool inserted = false;
+    unsigned int idx = vertexCache.findOrInsert(
+        i, static_cast<unsigned int>(positions.size() / 3), inserted);
 
-    if (it != vertexCache.end())
+    if (!inserted)
     {
         // found cache
-        return it->second;
+        return idx;
     }
 
     assert(in_positions.size() > static_cast<unsigned int>(3 * i.v_idx + 2));
@@ -541,9 +706,6 @@ updateVertex(std::map<vertex_index, unsigned int> &vertexCache,
             in_texcoords[2 * static_cast<size_t>(i.vt_idx) + 1]);
     }
 
-    unsigned int idx = static_cast<unsigned int>(positions.size() / 3 - 1);
-    vertexCache[i] = idx;
-
     return idx;
 }
 
@@ -572,8 +734,9 @@ static void InitMaterial(material_t &material)
     material.unknown_parameter.clear();
 }
 
+template <typename Cache>
 static bool exportFaceGroupToShape(
-    shape_t &shape, std::map<vertex_index, unsigned int> vertexCache,
+    shape_t &shape, Cache &vertexCache,
     const std::vector<float> &in_positions,
     const std::vector<float> &in_normals,
     const std::vector<float> &in_texcoords,
@@ -938,10 +1101,17 @@ bool MaterialFileReader::operator()(const std::string &matId,
     return true;
 }
 
-bool LoadObj(std::vector<shape_t> &shapes,       // [output]
-             std::vector<material_t> &materials, // [output]
-             std::string &err, const char *filename, const char *mtl_basepath,
-             bool trianglulate)
+template <typename Cache>
+static bool LoadObjStream(std::vector<shape_t> &shapes,
+                          std::vector<material_t> &materials,
+                          std::string &err, std::istream &inStream,
+                          MaterialReader &readMatFn, bool triangulate);
+
+template <typename Cache>
+static bool LoadObjFile(std::vector<shape_t> &shapes,
+                        std::vector<material_t> &materials, std::string &err,
+                        const char *filename, const char *mtl_basepath,
+                        bool trianglulate)
 {
 
     shapes.clear();
@@ -963,15 +1133,33 @@ bool LoadObj(std::vector<shape_t> &shapes,       // [output]
     }
     MaterialFileReader matFileReader(basePath);
 
-    return LoadObj(shapes, materials, err, ifs, matFileReader, trianglulate);
+    return LoadObjStream<Cache>(shapes, materials, err, ifs, matFileReader,
+                                trianglulate);
 }
 
 bool LoadObj(std::vector<shape_t> &shapes,       // [output]
              std::vector<material_t> &materials, // [output]
-             std::string &err, std::istream &inStream,
-             MaterialReader &readMatFn, bool triangulate)
+             std::string &err, const char *filename, const char *mtl_basepath,
+             bool trianglulate)
 {
-    std::stringstream errss;
+    return LoadObjFile<VertexCache>(shapes, materials, err, filename,
+                                    mtl_basepath, trianglulate);
+}
+
+bool LoadObjMapCache(std::vector<shape_t> &shapes,       // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err, const char *filename,
+                     const char *mtl_basepath, bool trianglulate)
+{
+    return LoadObjFile<MapVertexCache>(shapes, materials, err, filename,
+                                       mtl_basepath, trianglulate);
+}
+
+// Parser state shared by the serial and the parallel loader.
+template <typename Cache = VertexCache>
+struct obj_load_state
+{
+    obj_load_state() : material(-1) {}
 
     std::vector<float> v;
     std::vector<float> vn;
@@ -982,10 +1170,238 @@ bool LoadObj(std::vector<shape_t> &shapes,       // [output]
 
     // material
     std::map<std::string, int> material_map;
-    std::map<vertex_index, unsigned int> vertexCache;
-    int material = -1;
+    Cache vertexCache;
+    int material;
 
     shape_t shape;
+};
+
+// Handles every statement except v/vn/vt/f (usemtl, mtllib, g, o, t).
+// `token` points at the statement with leading space skipped.
+// Returns false only when the material reader fails.
+template <typename Cache>
+static bool parseDirective(obj_load_state<Cache> &st, const char *token,
+                           std::vector<shape_t> &shapes,
+                           std::vector<material_t> &materials,
+                           std::string &err, MaterialReader &readMatFn,
+                           bool triangulate)
+{
+    // use mtl
+    if ((0 == strncmp(token, "usemtl", 6)) && IS_SPACE((token[6])))
+    {
+
+        char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        token += 7;
+#ifdef _MSC_VER
+        sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+        sscanf(token, "%s", namebuf);
+#endif
+
+        int newMaterialId = -1;
+        if (st.material_map.find(namebuf) != st.material_map.end())
+        {
+            newMaterialId = st.material_map[namebuf];
+        }
+        else
+        {
+            // { error!! material not found }
+        }
+
+        if (newMaterialId != st.material)
+        {
+            // Create per-face material
+            exportFaceGroupToShape(st.shape, st.vertexCache, st.v, st.vn,
+                                   st.vt, st.faceGroup, st.tags, st.material,
+                                   st.name, true, triangulate);
+            st.faceGroup.clear();
+            st.material = newMaterialId;
+        }
+
+        return true;
+    }
+
+    // load mtl
+    if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6])))
+    {
+        char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        token += 7;
+#ifdef _MSC_VER
+        sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+        sscanf(token, "%s", namebuf);
+#endif
+
+        std::string err_mtl;
+        bool ok = readMatFn(namebuf, materials, st.material_map, err_mtl);
+        err += err_mtl;
+
+        if (!ok)
+        {
+            st.faceGroup.clear(); // for safety
+            return false;
+        }
+
+        return true;
+    }
+
+    // group name
+    if (token[0] == 'g' && IS_SPACE((token[1])))
+    {
+
+        // flush previous face group.
+        bool ret =
+            exportFaceGroupToShape(st.shape, st.vertexCache, st.v, st.vn,
+                                   st.vt, st.faceGroup, st.tags, st.material,
+                                   st.name, true, triangulate);
+        if (ret)
+        {
+            shapes.push_back(st.shape);
+        }
+
+        st.shape = shape_t();
+
+        // material = -1;
+        st.faceGroup.clear();
+
+        std::vector<std::string> names;
+        names.reserve(2);
+
+        while (!IS_NEW_LINE(token[0]))
+        {
+            std::string str = parseString(token);
+            names.push_back(str);
+            token += strspn(token, " \t\r"); // skip tag
+        }
+
+        assert(names.size() > 0);
+
+        // names[0] must be 'g', so skip the 0th element.
+        if (names.size() > 1)
+        {
+            st.name = names[1];
+        }
+        else
+        {
+            st.name = "";
+        }
+
+        return true;
+    }
+
+    // object name
+    if (token[0] == 'o' && IS_SPACE((token[1])))
+    {
+
+        // flush previous face group.
+        bool ret =
+            exportFaceGroupToShape(st.shape, st.vertexCache, st.v, st.vn,
+                                   st.vt, st.faceGroup, st.tags, st.material,
+                                   st.name, true, triangulate);
+        if (ret)
+        {
+            shapes.push_back(st.shape);
+        }
+
+        // material = -1;
+        st.faceGroup.clear();
+        st.shape = shape_t();
+
+        // @todo { multiple object name? }
+        char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        token += 2;
+#ifdef _MSC_VER
+        sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+#else
+        sscanf(token, "%s", namebuf);
+#endif
+        st.name = std::string(namebuf);
+
+        return true;
+    }
+
+    if (token[0] == 't' && IS_SPACE(token[1]))
+    {
+        tag_t tag;
+
+        char namebuf[4096];
+        token += 2;
+        sscanf(token, "%s", namebuf);
+        tag.name = std::string(namebuf);
+
+        token += tag.name.size() + 1;
+
+        tag_sizes ts = parseTagTriple(token);
+
+        tag.intValues.resize(static_cast<size_t>(ts.num_ints));
+
+        for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i)
+        {
+            tag.intValues[i] = atoi(token);
+            token += strcspn(token, "/ \t\r") + 1;
+        }
+
+        tag.floatValues.resize(static_cast<size_t>(ts.num_floats));
+        for (size_t i = 0; i < static_cast<size_t>(ts.num_floats); ++i)
+        {
+            tag.floatValues[i] = parseFloat(token);
+            token += strcspn(token, "/ \t\r") + 1;
+        }
+
+        tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
+        for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i)
+        {
+            char stringValueBuffer[4096];
+
+            sscanf(token, "%s", stringValueBuffer);
+            tag.stringValues[i] = stringValueBuffer;
+            token += tag.stringValues[i].size() + 1;
+        }
+
+        st.tags.push_back(tag);
+    }
+
+
+    // Ignore unknown command.
+    return true;
+}
+
+// Flushes the last face group. Shared tail of both loaders.
+template <typename Cache>
+static void finishShapes(obj_load_state<Cache> &st,
+                         std::vector<shape_t> &shapes, bool triangulate)
+{
+    bool ret = exportFaceGroupToShape(st.shape, st.vertexCache, st.v, st.vn,
+                                      st.vt, st.faceGroup, st.tags,
+                                      st.material, st.name, true, triangulate);
+    if (ret)
+    {
+        shapes.push_back(st.shape);
+    }
+    st.faceGroup.clear(); // for safety
+}
+
+bool LoadObj(std::vector<shape_t> &shapes,       // [output]
+             std::vector<material_t> &materials, // [output]
+             std::string &err, std::istream &inStream,
+             MaterialReader &readMatFn, bool triangulate)
+{
+    return LoadObjStream<VertexCache>(shapes, materials, err, inStream,
+                                      readMatFn, triangulate);
+}
+
+template <typename Cache>
+static bool LoadObjStream(std::vector<shape_t> &shapes,
+                          std::vector<material_t> &materials,
+                          std::string &err, std::istream &inStream,
+                          MaterialReader &readMatFn, bool triangulate)
+{
+    std::stringstream errss;
+
+    obj_load_state<Cache> st;
+    std::vector<float> &v = st.v;
+    std::vector<float> &vn = st.vn;
+    std::vector<float> &vt = st.vt;
 
     int maxchars = 8192;                                  // Alloc enough size.
     std::vector<char> buf(static_cast<size_t>(maxchars)); // Alloc enough size.
@@ -1080,196 +1496,383 @@ bool LoadObj(std::vector<shape_t> &shapes,       // [output]
             }
 
             // replace with emplace_back + std::move on C++11
-            faceGroup.push_back(std::vector<vertex_index>());
-            faceGroup[faceGroup.size() - 1].swap(face);
+            st.faceGroup.push_back(std::vector<vertex_index>());
+            st.faceGroup[st.faceGroup.size() - 1].swap(face);
 
             continue;
         }
 
-        // use mtl
-        if ((0 == strncmp(token, "usemtl", 6)) && IS_SPACE((token[6])))
+        if (!parseDirective(st, token, shapes, materials, err, readMatFn,
+                            triangulate))
         {
+            return false;
+        }
+    }
 
-            char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-            token += 7;
-#ifdef _MSC_VER
-            sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-            sscanf(token, "%s", namebuf);
-#endif
+    finishShapes(st, shapes, triangulate);
 
-            int newMaterialId = -1;
-            if (material_map.find(namebuf) != material_map.end())
-            {
-                newMaterialId = material_map[namebuf];
-            }
-            else
-            {
-                // { error!! material not found }
-            }
+    err += errss.str();
+    return true;
+}
+
+// ---- Parallel loader ----
 
-            if (newMaterialId != material)
+// Read-only view of a whole file (mmap on POSIX, read into memory elsewhere)
+class obj_file_view
+{
+public:
+    explicit obj_file_view(const char *filename) : data_(NULL), size_(0)
+    {
+#ifndef _WIN32
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *p = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ,
+                           MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED)
             {
-                // Create per-face material
-                exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                       tags, material, name, true, triangulate);
-                faceGroup.clear();
-                material = newMaterialId;
+                data_ = static_cast<const char *>(p);
+                size_ = static_cast<size_t>(st.st_size);
             }
-
-            continue;
         }
-
-        // load mtl
-        if ((0 == strncmp(token, "mtllib", 6)) && IS_SPACE((token[6])))
+        else if (fstat(fd, &st) == 0)
         {
-            char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
-            token += 7;
-#ifdef _MSC_VER
-            sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
+            data_ = ""; // empty file
+        }
+        close(fd);
 #else
-            sscanf(token, "%s", namebuf);
+        std::ifstream ifs(filename, std::ios::binary);
+        if (!ifs)
+            return;
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        fallback_ = ss.str();
+        data_ = fallback_.c_str();
+        size_ = fallback_.size();
 #endif
+    }
 
-            std::string err_mtl;
-            bool ok = readMatFn(namebuf, materials, material_map, err_mtl);
-            err += err_mtl;
+    ~obj_file_view()
+    {
+#ifndef _WIN32
+        if (data_ && size_ > 0)
+            munmap(const_cast<char *>(data_), size_);
+#endif
+    }
 
-            if (!ok)
-            {
-                faceGroup.clear(); // for safety
-                return false;
-            }
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
 
-            continue;
-        }
+private:
+    obj_file_view(const obj_file_view &);
+    obj_file_view &operator=(const obj_file_view &);
 
-        // group name
-        if (token[0] == 'g' && IS_SPACE((token[1])))
-        {
+    const char *data_;
+    size_t size_;
+#ifdef _WIN32
+    std::string fallback_;
+#endif
+};
 
-            // flush previous face group.
-            bool ret =
-                exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                       tags, material, name, true, triangulate);
-            if (ret)
-            {
-                shapes.push_back(shape);
-            }
+// Marks an index slot that was not present in the face statement
+// (e.g. the vt in "1//2"), as opposed to a relative index.
+static const int kAbsentIndex = INT_MIN;
 
-            shape = shape_t();
+// One statement recorded by a worker, replayed in order by the merge step.
+struct obj_chunk_record
+{
+    bool isFace;
+    size_t begin, count; // face: range in obj_chunk::corners
+    // face: number of v/vn/vt seen earlier in this chunk (for relative idx)
+    int localV, localVn, localVt;
+    std::string directive; // non-geometry statement text
+};
 
-            // material = -1;
-            faceGroup.clear();
+struct obj_chunk
+{
+    const char *begin;
+    const char *end;
+    std::vector<float> v, vn, vt;
+    std::vector<int> corners; // raw (v, vt, vn) per face corner
+    std::vector<obj_chunk_record> records;
+};
 
-            std::vector<std::string> names;
-            names.reserve(2);
+// Face triple as written in the file, before fixIndex().
+static void parseRawTriple(const char *&token, int &v, int &vt, int &vn)
+{
+    vt = kAbsentIndex;
+    vn = kAbsentIndex;
 
-            while (!IS_NEW_LINE(token[0]))
-            {
-                std::string str = parseString(token);
-                names.push_back(str);
-                token += strspn(token, " \t\r"); // skip tag
-            }
+    v = atoi(token);
+    token += strcspn(token, "/ \t\r");
+    if (token[0] != '/')
+        return;
+    token++;
 
-            assert(names.size() > 0);
+    // i//k
+    if (token[0] == '/')
+    {
+        token++;
+        vn = atoi(token);
+        token += strcspn(token, "/ \t\r");
+        return;
+    }
 
-            // names[0] must be 'g', so skip the 0th element.
-            if (names.size() > 1)
-            {
-                name = names[1];
-            }
-            else
-            {
-                name = "";
-            }
+    // i/j/k or i/j
+    vt = atoi(token);
+    token += strcspn(token, "/ \t\r");
+    if (token[0] != '/')
+        return;
 
-            continue;
-        }
+    token++; // skip '/'
+    vn = atoi(token);
+    token += strcspn(token, "/ \t\r");
+}
 
-        // object name
-        if (token[0] == 'o' && IS_SPACE((token[1])))
-        {
+// Tokenizes one chunk. Mirrors the statement tests of the serial loop.
+static void parseChunk(obj_chunk &chunk)
+{
+    std::string linebuf;
+    const char *p = chunk.begin;
+    while (p < chunk.end)
+    {
+        const char *eol = static_cast<const char *>(
+            memchr(p, '\n', static_cast<size_t>(chunk.end - p)));
+        const char *lineEnd = eol ? eol : chunk.end;
 
-            // flush previous face group.
-            bool ret =
-                exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                       tags, material, name, true, triangulate);
-            if (ret)
-            {
-                shapes.push_back(shape);
-            }
+        // Copy so the parsers see a NUL terminated line like the serial path
+        linebuf.assign(p, lineEnd);
+        p = eol ? eol + 1 : chunk.end;
 
-            // material = -1;
-            faceGroup.clear();
-            shape = shape_t();
+        if (!linebuf.empty() && linebuf[linebuf.size() - 1] == '\r')
+            linebuf.erase(linebuf.size() - 1);
+        if (linebuf.empty())
+            continue;
 
-            // @todo { multiple object name? }
-            char namebuf[TINYOBJ_SSCANF_BUFFER_SIZE];
+        const char *token = linebuf.c_str();
+        token += strspn(token, " \t");
+        if (token[0] == '\0' || token[0] == '#')
+            continue;
+
+        if (token[0] == 'v' && IS_SPACE((token[1])))
+        {
             token += 2;
-#ifdef _MSC_VER
-            sscanf_s(token, "%s", namebuf, (unsigned)_countof(namebuf));
-#else
-            sscanf(token, "%s", namebuf);
-#endif
-            name = std::string(namebuf);
+            float x, y, z;
+            parseFloat3(x, y, z, token);
+            chunk.v.push_back(x);
+            chunk.v.push_back(y);
+            chunk.v.push_back(z);
+            continue;
+        }
 
+        if (token[0] == 'v' && token[1] == 'n' && IS_SPACE((token[2])))
+        {
+            token += 3;
+            float x, y, z;
+            parseFloat3(x, y, z, token);
+            chunk.vn.push_back(x);
+            chunk.vn.push_back(y);
+            chunk.vn.push_back(z);
             continue;
         }
 
-        if (token[0] == 't' && IS_SPACE(token[1]))
+        if (token[0] == 'v' && token[1] == 't' && IS_SPACE((token[2])))
         {
-            tag_t tag;
+            token += 3;
+            float x, y;
+            parseFloat2(x, y, token);
+            chunk.vt.push_back(x);
+            chunk.vt.push_back(y);
+            continue;
+        }
+
+        obj_chunk_record rec;
+        rec.isFace = false;
+        rec.begin = rec.count = 0;
+        rec.localV = static_cast<int>(chunk.v.size() / 3);
+        rec.localVn = static_cast<int>(chunk.vn.size() / 3);
+        rec.localVt = static_cast<int>(chunk.vt.size() / 2);
 
-            char namebuf[4096];
+        if (token[0] == 'f' && IS_SPACE((token[1])))
+        {
             token += 2;
-            sscanf(token, "%s", namebuf);
-            tag.name = std::string(namebuf);
+            token += strspn(token, " \t");
 
-            token += tag.name.size() + 1;
+            rec.isFace = true;
+            rec.begin = chunk.corners.size() / 3;
+            while (!IS_NEW_LINE(token[0]))
+            {
+                int vi, vti, vni;
+                parseRawTriple(token, vi, vti, vni);
+                chunk.corners.push_back(vi);
+                chunk.corners.push_back(vti);
+                chunk.corners.push_back(vni);
+                token += strspn(token, " \t\r");
+            }
+            rec.count = chunk.corners.size() / 3 - rec.begin;
+        }
+        else
+        {
+            rec.directive = token;
+        }
+        chunk.records.push_back(rec);
+    }
+}
 
-            tag_sizes ts = parseTagTriple(token);
+static inline int fixRawIndex(int raw, int n)
+{
+    return (raw == kAbsentIndex) ? -1 : fixIndex(raw, n);
+}
 
-            tag.intValues.resize(static_cast<size_t>(ts.num_ints));
+bool LoadObjParallel(std::vector<shape_t> &shapes,       // [output]
+                     std::vector<material_t> &materials, // [output]
+                     std::string &err, const char *filename,
+                     const char *mtl_basepath, bool triangulate,
+                     int num_threads)
+{
+    shapes.clear();
+
+    obj_file_view file(filename);
+    if (!file.data())
+    {
+        std::stringstream errss;
+        errss << "Cannot open file [" << filename << "]" << std::endl;
+        err = errss.str();
+        return false;
+    }
+
+    if (num_threads <= 0)
+    {
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+        if (num_threads <= 0)
+            num_threads = 1;
+    }
 
-            for (size_t i = 0; i < static_cast<size_t>(ts.num_ints); ++i)
+    // Split into a few chunks per thread, each ending on a line boundary
+    const size_t minChunk = 1 << 16;
+    size_t numChunks = static_cast<size_t>(num_threads) * 4;
+    if (file.size() / numChunks < minChunk)
+        numChunks = file.size() / minChunk + 1;
+
+    std::vector<obj_chunk> chunks;
+    const char *fileEnd = file.data() + file.size();
+    const char *cur = file.data();
+    for (size_t i = 0; i < numChunks && cur < fileEnd; i++)
+    {
+        const char *end = (i + 1 == numChunks)
+                              ? fileEnd
+                              : file.data() + file.size() * (i + 1) / numChunks;
+        if (end < cur)
+            end = cur;
+        if (end < fileEnd)
+        {
+            const char *nl = static_cast<const char *>(
+                memchr(end, '\n', static_cast<size_t>(fileEnd - end)));
+            end = nl ? nl + 1 : fileEnd;
+        }
+        obj_chunk chunk;
+        chunk.begin = cur;
+        chunk.end = end;
+        chunks.push_back(chunk);
+        cur = end;
+    }
+
+    // Tokenize on a pool of workers pulling chunks in order
+    std::atomic<size_t> nextChunk(0);
+    std::vector<std::thread> workers;
+    size_t numWorkers =
+        std::min(chunks.size(), static_cast<size_t>(num_threads));
+    for (size_t t = 0; t < numWorkers; t++)
+    {
+        workers.push_back(std::thread([&chunks, &nextChunk]() {
+            for (;;)
             {
-                tag.intValues[i] = atoi(token);
-                token += strcspn(token, "/ \t\r") + 1;
+                size_t i = nextChunk.fetch_add(1);
+                if (i >= chunks.size())
+                    break;
+                parseChunk(chunks[i]);
             }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
 
-            tag.floatValues.resize(static_cast<size_t>(ts.num_floats));
-            for (size_t i = 0; i < static_cast<size_t>(ts.num_floats); ++i)
+    // Merge attributes in file order
+    obj_load_state<> st;
+    size_t totalV = 0, totalVn = 0, totalVt = 0;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        totalV += chunks[i].v.size();
+        totalVn += chunks[i].vn.size();
+        totalVt += chunks[i].vt.size();
+    }
+    st.v.reserve(totalV);
+    st.vn.reserve(totalVn);
+    st.vt.reserve(totalVt);
+
+    std::string basePath;
+    if (mtl_basepath)
+    {
+        basePath = mtl_basepath;
+    }
+    MaterialFileReader matFileReader(basePath);
+
+    // Replay statements in order; relative indices are resolved against the
+    // number of attributes seen before the face, exactly like the serial path
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        obj_chunk &chunk = chunks[c];
+        const int baseV = static_cast<int>(st.v.size() / 3);
+        const int baseVn = static_cast<int>(st.vn.size() / 3);
+        const int baseVt = static_cast<int>(st.vt.size() / 2);
+        st.v.insert(st.v.end(), chunk.v.begin(), chunk.v.end());
+        st.vn.insert(st.vn.end(), chunk.vn.begin(), chunk.vn.end());
+        st.vt.insert(st.vt.end(), chunk.vt.begin(), chunk.vt.end());
+
+        for (size_t r = 0; r < chunk.records.size(); r++)
+        {
+            const obj_chunk_record &rec = chunk.records[r];
+            if (!rec.isFace)
             {
-                tag.floatValues[i] = parseFloat(token);
-                token += strcspn(token, "/ \t\r") + 1;
+                if (!parseDirective(st, rec.directive.c_str(), shapes,
+                                    materials, err, matFileReader,
+                                    triangulate))
+                {
+                    return false;
+                }
+                continue;
             }
 
-            tag.stringValues.resize(static_cast<size_t>(ts.num_strings));
-            for (size_t i = 0; i < static_cast<size_t>(ts.num_strings); ++i)
+            std::vector<vertex_index> face;
+            face.reserve(rec.count);
+            for (size_t k = 0; k < rec.count; k++)
             {
-                char stringValueBuffer[4096];
-
-                sscanf(token, "%s", stringValueBuffer);
-                tag.stringValues[i] = stringValueBuffer;
-                token += tag.stringValues[i].size() + 1;
+                const int *raw = &chunk.corners[(rec.begin + k) * 3];
+                face.push_back(vertex_index(
+                    fixRawIndex(raw[0], baseV + rec.localV),
+                    fixRawIndex(raw[1], baseVt + rec.localVt),
+                    fixRawIndex(raw[2], baseVn + rec.localVn)));
             }
-
-            tags.push_back(tag);
+            st.faceGroup.push_back(std::vector<vertex_index>());
+            st.faceGroup[st.faceGroup.size() - 1].swap(face);
         }
 
-        // Ignore unknown command.
+        // Free chunk memory as soon as it is merged, so only about one copy
+        // of the attributes is resident at a time (st.v only touches its
+        // reserved pages as chunks are appended)
+        std::vector<float>().swap(chunk.v);
+        std::vector<float>().swap(chunk.vn);
+        std::vector<float>().swap(chunk.vt);
+        std::vector<obj_chunk_record>().swap(chunk.records);
+        std::vector<int>().swap(chunk.corners);
     }
 
-    bool ret = exportFaceGroupToShape(shape, vertexCache, v, vn, vt, faceGroup,
-                                      tags, material, name, true, triangulate);
-    if (ret)
-    {
-        shapes.push_back(shape);
-    }
-    faceGroup.clear(); // for safety
-
-    err += errss.str();
+    finishShapes(st, shapes, triangulate);
     return true;
 }
 
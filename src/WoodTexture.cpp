@@ -0,0 +1,212 @@
+// CPU wood background generator: scalar and SSE2 kernels, SIMD dispatch and
+// the tile scheduler. The AVX2 kernel lives in WoodTextureAVX2.cpp, which is
+// the only file built with AVX2 enabled.
+#include <cmath>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "./header/WoodTexture.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WOOD_HAS_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace wood_avx2
+{
+	bool compiled();
+	void bakeTile(int width, int height, int x0, int y0, int x1, int y1, unsigned char* rgba);
+}
+
+namespace wood_scalar
+{
+	struct VF
+	{
+		float v;
+		VF() {}
+		VF(float f) : v(f) {}
+	};
+	static const int VWIDTH = 1;
+
+	inline VF operator+(VF a, VF b) { return a.v + b.v; }
+	inline VF operator-(VF a, VF b) { return a.v - b.v; }
+	inline VF operator*(VF a, VF b) { return a.v * b.v; }
+	inline VF operator/(VF a, VF b) { return a.v / b.v; }
+	inline VF vload(const float* p) { return *p; }
+	inline void vstore(float* p, VF a) { *p = a.v; }
+	inline VF vfloor(VF a) { return floorf(a.v); }
+	inline VF vmin(VF a, VF b) { return fminf(a.v, b.v); }
+	inline VF vmax(VF a, VF b) { return fmaxf(a.v, b.v); }
+	inline VF vgt(VF a, VF b) { return a.v > b.v ? 1.0f : 0.0f; }
+	inline VF vselect(VF mask, VF a, VF b) { return mask.v != 0.0f ? a : b; }
+
+	inline void vreduce(VF x, VF& r, VF& q)
+	{
+		double j = nearbyint((double)x.v * 0.63661977236758134308);
+		r = (float)((double)x.v - j * 1.57079632679489661923);
+		q = (float)((long long)j & 3);
+	}
+
+	inline VF vmantissa(VF x, VF& e)
+	{
+		int exponent;
+		float m = frexpf(x.v, &exponent); // [0.5, 1)
+		e = (float)(exponent - 1);
+		return m * 2.0f;
+	}
+
+	inline VF vpow2i(VF n) { return ldexpf(1.0f, (int)n.v); }
+
+#include "./header/WoodKernel.inl"
+}
+
+#ifdef WOOD_HAS_SSE2
+namespace wood_sse2
+{
+	struct VF
+	{
+		__m128 v;
+		VF() {}
+		VF(__m128 x) : v(x) {}
+		VF(float f) : v(_mm_set1_ps(f)) {}
+	};
+	static const int VWIDTH = 4;
+
+	inline VF operator+(VF a, VF b) { return _mm_add_ps(a.v, b.v); }
+	inline VF operator-(VF a, VF b) { return _mm_sub_ps(a.v, b.v); }
+	inline VF operator*(VF a, VF b) { return _mm_mul_ps(a.v, b.v); }
+	inline VF operator/(VF a, VF b) { return _mm_div_ps(a.v, b.v); }
+	inline VF vload(const float* p) { return _mm_loadu_ps(p); }
+	inline void vstore(float* p, VF a) { _mm_storeu_ps(p, a.v); }
+	inline VF vmin(VF a, VF b) { return _mm_min_ps(a.v, b.v); }
+	inline VF vmax(VF a, VF b) { return _mm_max_ps(a.v, b.v); }
+	inline VF vgt(VF a, VF b) { return _mm_cmpgt_ps(a.v, b.v); }
+	inline VF vselect(VF mask, VF a, VF b) { return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+
+	// No roundps before SSE4.1: truncate, then step down where that rounded up.
+	// Exact for |x| < 2^31, far more than the kernel's range.
+	inline VF vfloor(VF a)
+	{
+		__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+		return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)));
+	}
+
+	inline void vreduce(VF x, VF& r, VF& q)
+	{
+		const __m128d twoOverPi = _mm_set1_pd(0.63661977236758134308);
+		const __m128d piOverTwo = _mm_set1_pd(1.57079632679489661923);
+		__m128d lo = _mm_cvtps_pd(x.v);
+		__m128d hi = _mm_cvtps_pd(_mm_movehl_ps(x.v, x.v));
+		__m128i jlo = _mm_cvtpd_epi32(_mm_mul_pd(lo, twoOverPi)); // round to nearest even
+		__m128i jhi = _mm_cvtpd_epi32(_mm_mul_pd(hi, twoOverPi));
+		__m128d rlo = _mm_sub_pd(lo, _mm_mul_pd(_mm_cvtepi32_pd(jlo), piOverTwo));
+		__m128d rhi = _mm_sub_pd(hi, _mm_mul_pd(_mm_cvtepi32_pd(jhi), piOverTwo));
+		r = _mm_movelh_ps(_mm_cvtpd_ps(rlo), _mm_cvtpd_ps(rhi));
+		__m128i j = _mm_unpacklo_epi64(jlo, jhi);
+		q = _mm_cvtepi32_ps(_mm_and_si128(j, _mm_set1_epi32(3)));
+	}
+
+	inline VF vmantissa(VF x, VF& e)
+	{
+		__m128i bits = _mm_castps_si128(x.v);
+		e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+		return _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+	}
+
+	inline VF vpow2i(VF n)
+	{
+		__m128i e = _mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127));
+		return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+	}
+
+#include "./header/WoodKernel.inl"
+}
+#endif
+
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+const char* woodSimdName(WOODSIMD simd)
+{
+	switch (simd) {
+		case WOODSIMD::SCALAR: return "scalar";
+		case WOODSIMD::SSE2: return "sse2";
+		case WOODSIMD::AVX2: return "avx2";
+		default: return "auto";
+	}
+}
+
+WOODSIMD resolveWoodSimd(WOODSIMD simd)
+{
+	bool avx2 = wood_avx2::compiled() && cpuHasAVX2();
+#ifdef WOOD_HAS_SSE2
+	bool sse2 = true;
+#else
+	bool sse2 = false;
+#endif
+	if (simd == WOODSIMD::AUTO || (simd == WOODSIMD::AVX2 && !avx2)) {
+		simd = avx2 ? WOODSIMD::AVX2 : WOODSIMD::SSE2;
+	}
+	if (simd == WOODSIMD::SSE2 && !sse2) {
+		simd = WOODSIMD::SCALAR;
+	}
+	return simd;
+}
+
+void bakeWoodTexture(int width, int height, vector<unsigned char>& rgba, int threads, WOODSIMD simd)
+{
+	rgba.assign((size_t)max(width, 0) * max(height, 0) * 4, 0);
+	if (width <= 0 || height <= 0) return;
+
+	void (*bakeTile)(int, int, int, int, int, int, unsigned char*) = wood_scalar::woodBakeTile;
+	switch (resolveWoodSimd(simd)) {
+		case WOODSIMD::AVX2: bakeTile = wood_avx2::bakeTile; break;
+#ifdef WOOD_HAS_SSE2
+		case WOODSIMD::SSE2: bakeTile = wood_sse2::woodBakeTile; break;
+#endif
+		default: break;
+	}
+
+	// Tiles are independent (even-aligned, so quads never straddle two)
+	const int TILE = 64;
+	int tilesX = (width + TILE - 1) / TILE;
+	int tilesY = (height + TILE - 1) / TILE;
+	int tileCount = tilesX * tilesY;
+	if (threads <= 0) threads = (int)thread::hardware_concurrency();
+	threads = max(1, min(threads, tileCount));
+
+	atomic<int> nextTile(0);
+	auto worker = [&]() {
+		for (int t = nextTile++; t < tileCount; t = nextTile++) {
+			int x0 = (t % tilesX) * TILE, y0 = (t / tilesX) * TILE;
+			bakeTile(width, height, x0, y0, min(x0 + TILE, width), min(y0 + TILE, height), rgba.data());
+		}
+	};
+
+	vector<thread> pool;
+	for (int i = 1; i < threads; i++) pool.emplace_back(worker);
+	worker();
+	for (auto& t : pool) t.join();
+}
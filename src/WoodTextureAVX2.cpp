@@ -0,0 +1,82 @@
+// AVX2 level of the CPU wood generator (see WoodTexture.cpp). This file is
+// compiled with AVX2 enabled and only called after a runtime CPU check.
+// FMA is deliberately left off so results match the SSE2/scalar levels.
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#ifdef __AVX2__
+#include <immintrin.h>
+
+namespace wood_avx2
+{
+	struct VF
+	{
+		__m256 v;
+		VF() {}
+		VF(__m256 x) : v(x) {}
+		VF(float f) : v(_mm256_set1_ps(f)) {}
+	};
+	static const int VWIDTH = 8;
+
+	inline VF operator+(VF a, VF b) { return _mm256_add_ps(a.v, b.v); }
+	inline VF operator-(VF a, VF b) { return _mm256_sub_ps(a.v, b.v); }
+	inline VF operator*(VF a, VF b) { return _mm256_mul_ps(a.v, b.v); }
+	inline VF operator/(VF a, VF b) { return _mm256_div_ps(a.v, b.v); }
+	inline VF vload(const float* p) { return _mm256_loadu_ps(p); }
+	inline void vstore(float* p, VF a) { _mm256_storeu_ps(p, a.v); }
+	inline VF vfloor(VF a) { return _mm256_floor_ps(a.v); }
+	inline VF vmin(VF a, VF b) { return _mm256_min_ps(a.v, b.v); }
+	inline VF vmax(VF a, VF b) { return _mm256_max_ps(a.v, b.v); }
+	inline VF vgt(VF a, VF b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+	inline VF vselect(VF mask, VF a, VF b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+	inline void vreduce(VF x, VF& r, VF& q)
+	{
+		const __m256d twoOverPi = _mm256_set1_pd(0.63661977236758134308);
+		const __m256d piOverTwo = _mm256_set1_pd(1.57079632679489661923);
+		__m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(x.v));
+		__m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(x.v, 1));
+		__m256d jlo = _mm256_round_pd(_mm256_mul_pd(lo, twoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d jhi = _mm256_round_pd(_mm256_mul_pd(hi, twoOverPi), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m128 rlo = _mm256_cvtpd_ps(_mm256_sub_pd(lo, _mm256_mul_pd(jlo, piOverTwo)));
+		__m128 rhi = _mm256_cvtpd_ps(_mm256_sub_pd(hi, _mm256_mul_pd(jhi, piOverTwo)));
+		r = _mm256_insertf128_ps(_mm256_castps128_ps256(rlo), rhi, 1);
+		__m256i j = _mm256_set_m128i(_mm256_cvtpd_epi32(jhi), _mm256_cvtpd_epi32(jlo));
+		q = _mm256_cvtepi32_ps(_mm256_and_si256(j, _mm256_set1_epi32(3)));
+	}
+
+	inline VF vmantissa(VF x, VF& e)
+	{
+		__m256i bits = _mm256_castps_si256(x.v);
+		e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+		return _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)), _mm256_set1_epi32(0x3F800000)));
+	}
+
+	inline VF vpow2i(VF n)
+	{
+		__m256i e = _mm256_add_epi32(_mm256_cvttps_epi32(n.v), _mm256_set1_epi32(127));
+		return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+	}
+
+#include "./header/WoodKernel.inl"
+
+	bool compiled() { return true; }
+
+	void bakeTile(int width, int height, int x0, int y0, int x1, int y1, unsigned char* rgba)
+	{
+		woodBakeTile(width, height, x0, y0, x1, y1, rgba);
+	}
+}
+
+#else
+
+namespace wood_avx2
+{
+	bool compiled() { return false; }
+	void bakeTile(int, int, int, int, int, int, unsigned char*) {}
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include <iostream>
+#include <glad/glad.h>
+#include "RenderState.h"
+
+using namespace std;
+
+// The wood background does not depend on time or the camera, so it is
+// rendered once into a texture of the framebuffer size and only redrawn
+// when that size changes. Every other frame just copies the texture.
+class BackgroundCache
+{
+public:
+	unsigned int texture = 0;
+	int width = 0, height = 0;
+
+	// Makes the texture match w x h, calling render() into it when it does
+	// not. Restores the caller's framebuffer and viewport. Returns false if
+	// there is nothing to draw (e.g. a minimized window).
+	template <class RenderFn>
+	bool update(int w, int h, RenderFn render)
+	{
+		if (w <= 0 || h <= 0) return false;
+		if (w == width && h == height && texture != 0) return true;
+
+		if (texture == 0) {
+			glGenTextures(1, &texture);
+			glGenFramebuffers(1, &fbo);
+		}
+		RenderState::current().bindTextureForUpload(texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		GLint previousFBO = 0, viewport[4];
+		glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFBO);
+		glGetIntegerv(GL_VIEWPORT, viewport);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+		bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+		if (complete) {
+			glViewport(0, 0, w, h);
+			glClear(GL_COLOR_BUFFER_BIT);
+			render();
+			width = w;
+			height = h;
+		} else {
+			cout << "Background cache framebuffer is incomplete" << endl;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		return complete;
+	}
+
+	// Forces a redraw on the next update() (e.g. after a shader reload)
+	void invalidate()
+	{
+		width = height = 0;
+	}
+
+private:
+	unsigned int fbo = 0;
+};
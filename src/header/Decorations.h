@@ -0,0 +1,301 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "Object.h"
+#include "HandRegions.h"
+#include "Shader.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
+
+using namespace std;
+
+// Decorations placed on the nails. The value doubles as the finger index
+// and as the `isPattern` code the fragment shader colors by.
+enum class DECORATIONKIND
+{
+	DIAMOND = 1, // thumb
+	PYRAMID = 2, // index finger
+	STAR = 3     // middle finger
+};
+
+const int DECORATION_KIND_COUNT = 3;
+
+// fract(sin(dot(uv, k)) * 43758.5453), the shaders' per-triangle random
+inline float shaderHash(const glm::vec2& uv, const glm::vec2& k)
+{
+	float v = sinf(uv.x * k.x + uv.y * k.y) * 43758.5453f;
+	return v - floorf(v);
+}
+
+// One decoration, four vec4 attributes with divisor 1. What the axes mean
+// depends on the kind:
+//   DIAMOND  axisA = tangent, axisB = bitangent, size/height at progress 1
+//   STAR     axisA = tangent, axisB = bitangent, size = star radius
+//   PYRAMID  axisA/axisB = first two triangle corners relative to center
+struct DecorationInstance
+{
+	glm::vec3 center;
+	float seed;
+	glm::vec3 normal;
+	float threshold; // visible once threshold < progress * density
+	glm::vec3 axisA;
+	float size;
+	glm::vec3 axisB;
+	float height;
+};
+
+static_assert(sizeof(DecorationInstance) == 64, "DecorationInstance is uploaded as four vec4");
+
+// Instanced nail decorations. build() classifies the nail triangles once on
+// the CPU and uploads one instance buffer per kind, sorted by threshold, so
+// the growing density is just a shorter instance count. Each kind draws a
+// small template mesh (decorationShader.vert expands it per instance);
+// nothing is generated per frame.
+class DecorationRenderer
+{
+public:
+	void build(const Object& hand)
+	{
+		vector<DecorationInstance> instances[DECORATION_KIND_COUNT];
+		classify(hand, instances);
+		for (int k = 0; k < DECORATION_KIND_COUNT; k++) {
+			sort(instances[k].begin(), instances[k].end(),
+				[](const DecorationInstance& a, const DecorationInstance& b) { return a.threshold < b.threshold; });
+			thresholds[k].clear();
+			centers[k] = glm::vec3(0.0f);
+			for (const auto& inst : instances[k]) {
+				thresholds[k].push_back(inst.threshold);
+				centers[k] = centers[k] + inst.center / (float)instances[k].size();
+			}
+			upload(k, instances[k]);
+		}
+		cout << "Decorations: " << thresholds[0].size() << " diamonds, " << thresholds[1].size()
+			<< " pyramids, " << thresholds[2].size() << " stars" << endl;
+	}
+
+	// Instances of `kind` shown at `progress` (0..1)
+	GLsizei visibleCount(DECORATIONKIND kind, float progress) const
+	{
+		const vector<float>& t = thresholds[index(kind)];
+		float limit = progress * density(kind);
+		return (GLsizei)(lower_bound(t.begin(), t.end(), limit) - t.begin());
+	}
+
+	// Model-space mean of the decoration centers of `kind` (sort depth)
+	glm::vec3 center(DECORATIONKIND kind) const { return centers[index(kind)]; }
+
+	// Queues the instances of `kind` shown at `progress` as a TRANSLUCENT
+	// item. `item` comes with the program (decorationShader.vert), mvp and
+	// depth filled in by the caller.
+	void submit(RenderQueue& queue, DrawItem item, DECORATIONKIND kind, float progress, bool finished) const
+	{
+		int k = index(kind);
+		item.instances = visibleCount(kind, progress);
+		if (item.instances == 0) return;
+		item.layer = RENDERLAYER::TRANSLUCENT;
+		item.vao = vao[k];
+		item.first = 0;
+		item.count = templateVertices[k];
+		item.params[0] = (float)kind;
+		item.params[1] = progress;
+		item.params[2] = finished ? 1.0f : 0.0f;
+		item.setUniforms = setUniforms;
+		queue.submit(item);
+	}
+
+private:
+	unsigned int vao[DECORATION_KIND_COUNT] = {};
+	unsigned int templateVBO[DECORATION_KIND_COUNT] = {};
+	unsigned int instanceVBO[DECORATION_KIND_COUNT] = {};
+	GLsizei templateVertices[DECORATION_KIND_COUNT] = {};
+	vector<float> thresholds[DECORATION_KIND_COUNT];
+	glm::vec3 centers[DECORATION_KIND_COUNT];
+
+	static int index(DECORATIONKIND kind) { return (int)kind - 1; }
+
+	static void setUniforms(ShaderProgram& program, const DrawItem& item)
+	{
+		static const ShaderProgram::UniformId decorKind = ShaderProgram::uniform("decorKind");
+		static const ShaderProgram::UniformId decorProgress = ShaderProgram::uniform("decorProgress");
+		static const ShaderProgram::UniformId decorFinished = ShaderProgram::uniform("decorFinished");
+		program.setInt(decorKind, (int)item.params[0]);
+		program.setFloat(decorProgress, item.params[1]);
+		program.setInt(decorFinished, (int)item.params[2]);
+	}
+
+	// hash < progress * density decides whether a triangle is decorated yet
+	static float density(DECORATIONKIND kind)
+	{
+		switch (kind) {
+			case DECORATIONKIND::DIAMOND: return 0.5f;
+			case DECORATIONKIND::PYRAMID: return 0.6f;
+			default: return 1.0f;
+		}
+	}
+
+	static void orthonormalFrame(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent)
+	{
+		tangent = p1 - p0;
+		tangent = glm::length(tangent) < 1e-4f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::normalize(tangent);
+		bitangent = glm::cross(normal, tangent);
+		bitangent = glm::length(bitangent) < 1e-4f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::normalize(bitangent);
+	}
+
+	// Same selection the geometry shader makes per primitive: upward-facing
+	// triangles tagged with the nail band of the thumb, index or middle
+	// finger. Only the nail ranges are scanned once the hand is partitioned.
+	static void classify(const Object& hand, vector<DecorationInstance>* out)
+	{
+		vector<IndexRange> ranges;
+		if (hand.regions.size() == HAND_REGION_COUNT) {
+			for (int r = 1; r <= DECORATION_KIND_COUNT; r++) ranges.push_back(hand.regions[r]);
+		} else {
+			ranges.push_back({ 0, hand.drawCount() });
+		}
+
+		for (const IndexRange& range : ranges) {
+			size_t firstTriangle = range.first / 3, lastTriangle = (range.first + range.count) / 3;
+			for (size_t t = firstTriangle; t < lastTriangle; t++) {
+				glm::vec3 p[3];
+				glm::vec2 uv[3];
+				for (int c = 0; c < 3; c++) {
+					unsigned int v = hand.triangleVertex(t, c);
+					p[c] = glm::vec3(hand.positions[v * 3], hand.positions[v * 3 + 1], hand.positions[v * 3 + 2]);
+					uv[c] = glm::vec2(hand.texcoords[v * 2], hand.texcoords[v * 2 + 1]);
+				}
+				glm::vec2 centerUV = (uv[0] + uv[1] + uv[2]) / 3.0f;
+				unsigned char tag = handTriangleTag(hand, t);
+				if (!(tag & TAG_NAIL_BAND)) continue;
+				int finger = tag & TAG_FINGER_MASK;
+				if (finger < 1 || finger > DECORATION_KIND_COUNT) continue;
+
+				glm::vec3 n = glm::cross(p[1] - p[0], p[2] - p[0]);
+				if (glm::length(n) == 0.0f) continue;
+				n = glm::normalize(n);
+				if (n.y <= 0.5f) continue;
+
+				glm::vec3 center = (p[0] + p[1] + p[2]) / 3.0f;
+				DecorationInstance inst;
+				inst.normal = n;
+				switch ((DECORATIONKIND)finger) {
+					case DECORATIONKIND::DIAMOND: {
+						float hash = shaderHash(centerUV, glm::vec2(17.9128f, 83.2331f));
+						float h = hash * 7.1234f;
+						h -= floorf(h);
+						inst.center = center + n * 0.01f;
+						inst.seed = hash;
+						inst.threshold = hash;
+						orthonormalFrame(p[0], p[1], n, inst.axisA, inst.axisB);
+						inst.size = 0.04f + (0.09f - 0.04f) * h;
+						inst.height = 0.1f + (0.25f - 0.1f) * h;
+						break;
+					}
+					case DECORATIONKIND::PYRAMID: {
+						float hash = shaderHash(centerUV, glm::vec2(23.4567f, 65.7891f));
+						inst.center = center;
+						inst.seed = hash;
+						inst.threshold = hash;
+						inst.axisA = p[0] - center;
+						inst.axisB = p[1] - center;
+						inst.size = inst.height = 0.0f;
+						break;
+					}
+					case DECORATIONKIND::STAR: {
+						float hash = shaderHash(centerUV, glm::vec2(31.4159f, 27.1828f));
+						if (hash >= 0.5f) continue; // half of the triangles get a star
+						float s = hash * 3.7f;
+						s -= floorf(s);
+						inst.center = center;
+						inst.seed = hash;
+						inst.threshold = 0.0f; // density does not grow, the stars do
+						orthonormalFrame(p[0], p[1], n, inst.axisA, inst.axisB);
+						inst.size = 0.06f + (0.12f - 0.06f) * s;
+						inst.height = 0.0f;
+						break;
+					}
+				}
+				out[finger - 1].push_back(inst);
+			}
+		}
+	}
+
+	// Template meshes, one vertex = (vec3 shape, vec3 normal):
+	//   DIAMOND  shape = unit cone point (x, y on the base circle, z up to
+	//            the apex), normal = face normal of the unit cone
+	//   STAR     shape = (base angle, radius factor, lift along the normal)
+	//   PYRAMID  shape = (corner 0..2 or 3 = apex, face 0..3, unused)
+	static vector<float> templateMesh(DECORATIONKIND kind)
+	{
+		vector<float> v;
+		auto push = [&v](glm::vec3 s, glm::vec3 n) {
+			v.insert(v.end(), { s.x, s.y, s.z, n.x, n.y, n.z });
+		};
+		const float TWO_PI = 6.28318f;
+		if (kind == DECORATIONKIND::DIAMOND) {
+			const int segments = 12;
+			glm::vec3 apex(0.0f, 0.0f, 1.0f);
+			for (int i = 0; i < segments; i++) {
+				float a0 = i * TWO_PI / segments, a1 = (i + 1) * TWO_PI / segments;
+				glm::vec3 b0(cosf(a0), sinf(a0), 0.0f), b1(cosf(a1), sinf(a1), 0.0f);
+				glm::vec3 n = glm::normalize(glm::cross(b0 - apex, b1 - apex));
+				push(apex, n); push(b0, n); push(b1, n);
+			}
+			glm::vec3 down(0.0f, 0.0f, -1.0f);
+			for (int i = 0; i < segments; i++) {
+				float a0 = i * TWO_PI / segments, a1 = (i + 1) * TWO_PI / segments;
+				push(glm::vec3(0.0f), down);
+				push(glm::vec3(cosf(a0), sinf(a0), 0.0f), down);
+				push(glm::vec3(cosf(a1), sinf(a1), 0.0f), down);
+			}
+		} else if (kind == DECORATIONKIND::STAR) {
+			const int points = 10;
+			for (int i = 0; i < points; i++) {
+				int next = (i + 1) % points;
+				glm::vec3 up(0.0f, 0.0f, 1.0f);
+				push(glm::vec3(0.0f, 0.0f, 0.015f), up);
+				push(glm::vec3(i * TWO_PI / points, (i % 2 == 0) ? 1.0f : 0.4f, 0.01f), up);
+				push(glm::vec3(next * TWO_PI / points, (next % 2 == 0) ? 1.0f : 0.4f, 0.01f), up);
+			}
+		} else {
+			const int faces[4][3] = { { 0, 1, 3 }, { 1, 2, 3 }, { 2, 0, 3 }, { 0, 2, 1 } };
+			for (int f = 0; f < 4; f++) {
+				for (int c = 0; c < 3; c++) {
+					push(glm::vec3((float)faces[f][c], (float)f, 0.0f), glm::vec3(0.0f));
+				}
+			}
+		}
+		return v;
+	}
+
+	void upload(int k, const vector<DecorationInstance>& instances)
+	{
+		if (vao[k] == 0) {
+			glGenVertexArrays(1, &vao[k]);
+			glGenBuffers(1, &templateVBO[k]);
+			glGenBuffers(1, &instanceVBO[k]);
+		}
+		RenderState::current().bindVertexArray(vao[k]);
+
+		vector<float> mesh = templateMesh((DECORATIONKIND)(k + 1));
+		templateVertices[k] = (GLsizei)(mesh.size() / 6);
+		glBindBuffer(GL_ARRAY_BUFFER, templateVBO[k]);
+		glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(float), mesh.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO[k]);
+		glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(DecorationInstance), instances.data(), GL_STATIC_DRAW);
+		for (int i = 0; i < 4; i++) {
+			glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(DecorationInstance), (void*)(uintptr_t)(i * 16));
+			glEnableVertexAttribArray(2 + i);
+			glVertexAttribDivisor(2 + i, 1);
+		}
+		RenderState::current().bindVertexArray(0);
+	}
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// Binding point of the `FrameData` uniform block, shared by every program
+const GLuint FRAME_DATA_BINDING = 0;
+
+// CPU mirror of the std140 `FrameData` block declared in the shaders.
+// Keep both in sync: the three scalars share one vec4 slot, and each int of
+// fingerPainted[6] takes its own 16-byte slot (std140 array stride).
+struct FrameData
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	float time;
+	int activeFinger;
+	float patternProgress;
+	float pad0;
+	int fingerPainted[6][4];
+};
+
+static_assert(sizeof(FrameData) == 240, "FrameData must match the std140 block layout");
+
+// Uniform buffer holding FrameData, bound once at FRAME_DATA_BINDING.
+// update() orphans the old storage before writing so the driver never has
+// to wait for draws from the previous frame that still read it.
+class FrameUniformBuffer
+{
+public:
+	unsigned int id = 0;
+
+	void create()
+	{
+		glGenBuffers(1, &id);
+		glBindBuffer(GL_UNIFORM_BUFFER, id);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, id);
+	}
+
+	void update(const FrameData& data)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, id);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &data);
+	}
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+// Frame pacing policy for the windowed loop (set from the command line)
+struct FramePacing
+{
+	int swapInterval = 1;     // 0 = vsync off, 1 = vsync, -1 = adaptive (tears only when late)
+	double maxFps = 0.0;      // CPU frame cap, 0 = none
+	bool lowLatency = false;  // sample input as late as possible, never queue frames
+	double refreshHz = 60.0;  // display rate, filled in from the monitor
+
+	string describe() const
+	{
+		char text[128];
+		const char* vsync = swapInterval == 0 ? "off" : swapInterval < 0 ? "adaptive" : "on";
+		if (maxFps > 0.0) snprintf(text, sizeof(text), "vsync %s, cap %.0f fps, %s latency", vsync, maxFps, lowLatency ? "low" : "normal");
+		else snprintf(text, sizeof(text), "vsync %s, no cap, %s latency", vsync, lowLatency ? "low" : "normal");
+		return text;
+	}
+};
+
+// Decides when the next frame may start.
+//
+// Normal mode is a plain limiter: frames start at most maxFps times a
+// second, input is polled at the end of the previous frame.
+//
+// Low-latency mode moves the wait in front of input sampling and schedules
+// the frame start so that it finishes just before the next present:
+//   start = next present - (slowest recent work) - margin
+// where work is input sampling up to the end of glFinish() (the loop calls
+// glFinish before the swap in this mode, so the GPU never runs frames
+// ahead). Under vsync the next present is one refresh after the last one
+// and the margin absorbs jitter; with only a cap it is the cap's schedule.
+//
+// Waits sleep until `spin` before the deadline and busy-wait the rest;
+// `spin` follows the worst oversleep seen, so a coarse OS timer costs CPU
+// instead of missed deadlines.
+class FramePacer
+{
+public:
+	double marginMs = 1.0; // slack left before the present in low-latency mode
+
+	void configure(const FramePacing& p)
+	{
+		policy = p;
+		lastStart = lastPresent = targetPresent = Clock::time_point();
+		workCount = 0;
+		fill(work, work + WORK_HISTORY, 0.0);
+	}
+
+	const FramePacing& pacing() const { return policy; }
+
+	// Blocks until the next frame may start. Returns the time waited (ms).
+	double waitForFrameStart()
+	{
+		Clock::time_point now = Clock::now();
+		Clock::time_point deadline = now;
+		double period = periodSeconds();
+		if (policy.lowLatency) {
+			if (lastPresent != Clock::time_point() && period > 0.0) {
+				bool vsync = policy.swapInterval != 0;
+				// Under vsync the swap lines presents up with the refresh; a
+				// plain cap keeps its own schedule of present times instead
+				if (vsync || now - targetPresent > toDuration(period)) targetPresent = lastPresent;
+				targetPresent += toDuration(period);
+				double lead = slowestWorkMs() + (vsync ? marginMs : 0.0);
+				deadline = targetPresent - toDuration(lead / 1000.0);
+			}
+		} else if (policy.maxFps > 0.0 && lastStart != Clock::time_point()) {
+			deadline = lastStart + toDuration(period);
+			// Fell more than a frame behind: restart the schedule instead of
+			// rushing several frames out to catch up
+			if (now - deadline > toDuration(period)) deadline = now;
+		}
+		if (deadline > now) sleepUntil(deadline);
+		Clock::time_point end = Clock::now();
+		// The limiter keeps its nominal schedule so small overruns even out
+		lastStart = policy.maxFps > 0.0 && !policy.lowLatency ? deadline : end;
+		return chrono::duration<double, milli>(end - now).count();
+	}
+
+	// Call once the frame's input has been sampled
+	void inputSampled() { inputTime = Clock::now(); }
+
+	// Call when the frame's GPU work is done (low-latency mode, after glFinish)
+	void workFinished()
+	{
+		work[workCount % WORK_HISTORY] = chrono::duration<double, milli>(Clock::now() - inputTime).count();
+		workCount++;
+	}
+
+	// Call right after the swap. Returns the input age: ms from inputSampled()
+	// to the present, the latency this policy trades against.
+	double framePresented()
+	{
+		lastPresent = Clock::now();
+		return chrono::duration<double, milli>(lastPresent - inputTime).count();
+	}
+
+private:
+	typedef chrono::steady_clock Clock;
+	static const int WORK_HISTORY = 16;
+
+	FramePacing policy;
+	Clock::time_point lastStart, lastPresent, targetPresent, inputTime;
+	double work[WORK_HISTORY] = {};
+	int workCount = 0;
+	double spinMs = 1.0;
+
+	static Clock::duration toDuration(double seconds)
+	{
+		return chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds));
+	}
+
+	// Frame interval the schedule aims for, 0 = as fast as possible
+	double periodSeconds() const
+	{
+		double period = policy.maxFps > 0.0 ? 1.0 / policy.maxFps : 0.0;
+		if (policy.lowLatency && policy.swapInterval != 0 && policy.refreshHz > 0.0) {
+			period = max(period, abs(policy.swapInterval) / policy.refreshHz);
+		}
+		return period;
+	}
+
+	double slowestWorkMs() const
+	{
+		double slowest = 0.0;
+		int count = workCount < WORK_HISTORY ? workCount : WORK_HISTORY;
+		for (int i = 0; i < count; i++) slowest = max(slowest, work[i]);
+		return slowest;
+	}
+
+	void sleepUntil(Clock::time_point deadline)
+	{
+		Clock::time_point wake = deadline - toDuration(spinMs / 1000.0);
+		if (wake > Clock::now()) {
+			this_thread::sleep_until(wake);
+			double late = chrono::duration<double, milli>(Clock::now() - wake).count();
+			// Grow quickly on an oversleep, shrink slowly once the timer behaves
+			spinMs = late > spinMs ? min(late * 1.25, 4.0) : max(spinMs * 0.99, 0.25);
+		}
+		while (Clock::now() < deadline) this_thread::yield();
+	}
+};
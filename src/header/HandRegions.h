@@ -0,0 +1,142 @@
+#pragma once
+#include <vector>
+#include <cfloat>
+#include <glm/glm.hpp>
+#include "Object.h"
+
+using namespace std;
+
+// Triangle groups of the hand model: skin first, then one nail range per
+// finger (1 = thumb .. 5 = pinky)
+enum HANDREGION
+{
+	REGION_SKIN = 0,
+	HAND_REGION_COUNT = 6
+};
+
+// Per-vertex tag (Object::tags, vertex attribute 3): finger index in the
+// low bits, plus a bit for the band of the nail where decorations grow
+const unsigned char TAG_FINGER_MASK = 0x7;
+const unsigned char TAG_NAIL_BAND = 0x8;
+
+// A nail in texture space, [minU, maxU) x [minV, maxV)
+struct UVRegion
+{
+	float minU, minV, maxU, maxV;
+	int finger;
+};
+
+// The nail layout of female_hand.png: the bottom tenth of the texture,
+// left hand pinky -> thumb, then right hand thumb -> pinky. Replace this
+// table to retarget the regions to another model.
+inline const vector<UVRegion>& handUVRegions()
+{
+	static const vector<UVRegion> table = {
+		{ -FLT_MAX, -FLT_MAX, 0.1f, 0.1f, 5 },
+		{ 0.1f, -FLT_MAX, 0.2f, 0.1f, 4 },
+		{ 0.2f, -FLT_MAX, 0.3f, 0.1f, 3 },
+		{ 0.3f, -FLT_MAX, 0.4f, 0.1f, 2 },
+		{ 0.4f, -FLT_MAX, 0.5f, 0.1f, 1 },
+		{ 0.5f, -FLT_MAX, 0.6f, 0.1f, 1 },
+		{ 0.6f, -FLT_MAX, 0.7f, 0.1f, 2 },
+		{ 0.7f, -FLT_MAX, 0.8f, 0.1f, 3 },
+		{ 0.8f, -FLT_MAX, 0.9f, 0.1f, 4 },
+		{ 0.9f, -FLT_MAX, FLT_MAX, 0.1f, 5 }
+	};
+	return table;
+}
+
+// 0 = palm, otherwise the finger whose nail contains uv
+inline int fingerIndexFromUV(const glm::vec2& uv)
+{
+	for (const UVRegion& r : handUVRegions()) {
+		if (uv.x >= r.minU && uv.x < r.maxU && uv.y >= r.minV && uv.y < r.maxV) return r.finger;
+	}
+	return 0;
+}
+
+inline unsigned char handTagFromUV(const glm::vec2& uv)
+{
+	unsigned char tag = (unsigned char)fingerIndexFromUV(uv);
+	if (uv.y > 0.01f && uv.y < 0.08f) tag |= TAG_NAIL_BAND;
+	return tag;
+}
+
+inline glm::vec2 triangleCenterUV(const Object& hand, size_t t)
+{
+	glm::vec2 sum(0.0f);
+	for (int c = 0; c < 3; c++) {
+		unsigned int v = hand.triangleVertex(t, c);
+		sum = sum + glm::vec2(hand.texcoords[v * 2], hand.texcoords[v * 2 + 1]);
+	}
+	return sum / 3.0f;
+}
+
+// Tag of triangle t: the tag of its last (provoking) vertex once
+// tagHandVertices() ran, else computed from the center uv
+inline unsigned char handTriangleTag(const Object& hand, size_t t)
+{
+	if (!hand.tags.empty()) return hand.tags[hand.triangleVertex(t, 2)];
+	return handTagFromUV(triangleCenterUV(hand, t));
+}
+
+// Classifies every triangle once by its center uv and stores the result in
+// its provoking vertex, which `flat` shader inputs read. Each triangle is
+// rotated (winding kept) so a corner that already carries its tag becomes
+// the last one. A vertex whose tag is needed by two triangles is
+// duplicated, which only happens along nail borders. Returns the number
+// of added vertices.
+inline size_t tagHandVertices(Object& hand)
+{
+	const unsigned char UNSET = 0xFF;
+	size_t added = 0;
+	hand.tags.assign(hand.positions.size() / 3, UNSET);
+
+	for (size_t t = 0; t < hand.triangleCount(); t++) {
+		unsigned char want = handTagFromUV(triangleCenterUV(hand, t));
+		if (!hand.indexed) {
+			for (int c = 0; c < 3; c++) hand.tags[t * 3 + c] = want;
+			continue;
+		}
+
+		unsigned int* tri = &hand.indices[t * 3];
+		const int order[3] = { 2, 0, 1 };
+		int pick = -1;
+		for (int k : order) {
+			if (hand.tags[tri[k]] == want) { pick = k; break; }
+		}
+		if (pick < 0) {
+			for (int k : order) {
+				if (hand.tags[tri[k]] == UNSET) { hand.tags[tri[k]] = want; pick = k; break; }
+			}
+		}
+		if (pick < 0) {
+			tri[2] = hand.duplicateVertex(tri[2]);
+			hand.tags[tri[2]] = want;
+			pick = 2;
+			added++;
+		}
+		// Cyclic rotation that moves corner `pick` to the end
+		unsigned int a = tri[0], b = tri[1], c = tri[2];
+		if (pick == 0) { tri[0] = b; tri[1] = c; tri[2] = a; }
+		else if (pick == 1) { tri[0] = c; tri[1] = a; tri[2] = b; }
+	}
+
+	// Never provoking, so the value is not read; keep it meaningful anyway
+	for (size_t v = 0; v < hand.tags.size(); v++) {
+		if (hand.tags[v] == UNSET) {
+			hand.tags[v] = handTagFromUV(glm::vec2(hand.texcoords[v * 2], hand.texcoords[v * 2 + 1]));
+		}
+	}
+	return added;
+}
+
+// Sorts the hand's triangles into HANDREGION ranges (Object::regions)
+inline void partitionHandRegions(Object& hand)
+{
+	vector<int> region(hand.triangleCount());
+	for (size_t t = 0; t < region.size(); t++) {
+		region[t] = handTriangleTag(hand, t) & TAG_FINGER_MASK;
+	}
+	hand.partitionTriangles(region, HAND_REGION_COUNT);
+}
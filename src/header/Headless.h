@@ -0,0 +1,337 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#ifdef HAS_EGL_HEADLESS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include "stb_image_write.h"
+#include "WoodTexture.h"
+#include "FramePacer.h"
+
+using namespace std;
+
+// Command line options for offscreen rendering (--headless ...)
+struct HeadlessOptions
+{
+	bool enabled = false;
+	int width = 1280;
+	int height = 720;
+	int frames = 0;          // 0 = until the script ends
+	float fps = 30.0f;
+	string outDir = ".";
+	string format = "png";   // png | raw (tightly packed RGBA8, top row first)
+	string script;           // empty = built-in demo sequence
+	string tracePath;        // --profile: Chrome trace of every frame
+
+	// CPU wood background (no OpenGL needed)
+	string bakePath;         // --bake-background: write one image and exit
+	int threads = 0;         // 0 = all cores
+	WOODSIMD simd = WOODSIMD::AUTO;
+
+	string compressPath;     // --compress-texture: write <image>.texcache and exit
+
+	// Windowed mode only
+	FramePacing pacing;      // --vsync, --max-fps, --low-latency
+};
+
+inline void printHeadlessUsage()
+{
+	cout << "Usage: ICG_2025_HW2 [--vsync on|off|adaptive] [--max-fps F] [--low-latency]\n"
+		<< "       ICG_2025_HW2 --headless [--size WxH] [--frames N] [--fps F]\n"
+		<< "                    [--out DIR] [--format png|raw] [--script FILE]\n"
+		<< "                    [--profile TRACE.json]\n"
+		<< "       ICG_2025_HW2 --bake-background FILE.png [--size WxH] [--threads N]\n"
+		<< "                    [--simd scalar|sse2|avx2]\n"
+		<< "       ICG_2025_HW2 --compress-texture IMAGE.png" << endl;
+}
+
+inline bool parseHeadlessArgs(int argc, char** argv, HeadlessOptions& opt)
+{
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--headless") {
+			opt.enabled = true;
+		} else if (arg == "--size" && hasValue) {
+			if (sscanf(argv[++i], "%dx%d", &opt.width, &opt.height) != 2 || opt.width <= 0 || opt.height <= 0) {
+				cout << "Invalid --size, expected WxH" << endl;
+				return false;
+			}
+		} else if (arg == "--frames" && hasValue) {
+			opt.frames = atoi(argv[++i]);
+		} else if (arg == "--fps" && hasValue) {
+			opt.fps = (float)atof(argv[++i]);
+			if (opt.fps <= 0.0f) opt.fps = 30.0f;
+		} else if (arg == "--out" && hasValue) {
+			opt.outDir = argv[++i];
+		} else if (arg == "--format" && hasValue) {
+			opt.format = argv[++i];
+			if (opt.format != "png" && opt.format != "raw") {
+				cout << "Unknown --format " << opt.format << endl;
+				return false;
+			}
+		} else if (arg == "--script" && hasValue) {
+			opt.script = argv[++i];
+		} else if (arg == "--profile" && hasValue) {
+			opt.tracePath = argv[++i];
+		} else if (arg == "--bake-background" && hasValue) {
+			opt.bakePath = argv[++i];
+		} else if (arg == "--compress-texture" && hasValue) {
+			opt.compressPath = argv[++i];
+		} else if (arg == "--threads" && hasValue) {
+			opt.threads = atoi(argv[++i]);
+		} else if (arg == "--simd" && hasValue) {
+			string name = argv[++i];
+			if (name == "scalar") opt.simd = WOODSIMD::SCALAR;
+			else if (name == "sse2") opt.simd = WOODSIMD::SSE2;
+			else if (name == "avx2") opt.simd = WOODSIMD::AVX2;
+			else if (name != "auto") {
+				cout << "Unknown --simd " << name << endl;
+				return false;
+			}
+		} else if (arg == "--vsync" && hasValue) {
+			string mode = argv[++i];
+			if (mode == "on") opt.pacing.swapInterval = 1;
+			else if (mode == "off") opt.pacing.swapInterval = 0;
+			else if (mode == "adaptive") opt.pacing.swapInterval = -1;
+			else {
+				cout << "Unknown --vsync " << mode << endl;
+				return false;
+			}
+		} else if (arg == "--max-fps" && hasValue) {
+			opt.pacing.maxFps = max(atof(argv[++i]), 0.0);
+		} else if (arg == "--low-latency") {
+			opt.pacing.lowLatency = true;
+		} else {
+			printHeadlessUsage();
+			return false;
+		}
+	}
+	return true;
+}
+
+// One scripted input at a given time (seconds from start)
+//   key <A|B|C|D|E|S|SPACE|LEFT|RIGHT|UP|DOWN>   same as a key press
+//   orbit <dyaw> <dpitch>                        same as a mouse drag (degrees)
+//   zoom <steps>                                 same as the mouse wheel
+//   end                                          stop rendering
+struct ScriptEvent
+{
+	double time = 0.0;
+	string command;
+	int key = 0;
+	float a = 0.0f, b = 0.0f;
+};
+
+inline int scriptKeyCode(const string& name)
+{
+	if (name.size() == 1 && name[0] >= 'A' && name[0] <= 'Z') return GLFW_KEY_A + (name[0] - 'A');
+	if (name == "SPACE") return GLFW_KEY_SPACE;
+	if (name == "LEFT") return GLFW_KEY_LEFT;
+	if (name == "RIGHT") return GLFW_KEY_RIGHT;
+	if (name == "UP") return GLFW_KEY_UP;
+	if (name == "DOWN") return GLFW_KEY_DOWN;
+	return 0;
+}
+
+inline bool parseScript(istream& in, vector<ScriptEvent>& events)
+{
+	string line;
+	int lineNo = 0;
+	while (getline(in, line)) {
+		lineNo++;
+		size_t hash = line.find('#');
+		if (hash != string::npos) line.erase(hash);
+		stringstream ss(line);
+		ScriptEvent e;
+		if (!(ss >> e.time >> e.command)) continue; // blank line
+
+		bool ok = true;
+		if (e.command == "key") {
+			string name; ss >> name;
+			e.key = scriptKeyCode(name);
+			ok = e.key != 0;
+		} else if (e.command == "orbit") {
+			ok = (bool)(ss >> e.a >> e.b);
+		} else if (e.command == "zoom") {
+			ok = (bool)(ss >> e.a);
+		} else if (e.command != "end") {
+			ok = false;
+		}
+		if (!ok) {
+			cout << "Script error on line " << lineNo << ": " << line << endl;
+			return false;
+		}
+		events.push_back(e);
+	}
+	return true;
+}
+
+// Decorates every finger in turn, then lets the celebration spin run
+inline const char* defaultHeadlessScript()
+{
+	return
+		"0.5  key A\n"  "1.5  key S\n"
+		"5.5  key B\n"  "6.5  key S\n"
+		"10.5 key C\n"  "11.5 key S\n"
+		"15.5 key D\n"  "16.5 key S\n"
+		"20.5 key E\n"  "21.5 key S\n"
+		"25.5 key SPACE\n"
+		"27.0 orbit 30 -10\n"
+		"32.0 end\n";
+}
+
+#ifdef HAS_EGL_HEADLESS
+// OpenGL 3.3 core context without any window system, via EGL. Prefers the
+// Mesa surfaceless platform (works on GPU-less servers with llvmpipe) and
+// falls back to the default display. Rendering must go to an FBO.
+class HeadlessContext
+{
+public:
+	bool create()
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay) {
+			display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		}
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+			if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+				cout << "EGL: failed to initialize a display" << endl;
+				return false;
+			}
+		}
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			cout << "EGL: desktop OpenGL is not supported" << endl;
+			return false;
+		}
+
+		const EGLint contextAttribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		// EGL_KHR_no_config_context + EGL_KHR_surfaceless_context
+		context = eglCreateContext(display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs);
+		if (context == EGL_NO_CONTEXT) {
+			const EGLint configAttribs[] = {
+				EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+				EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+				EGL_NONE
+			};
+			EGLConfig config; EGLint count = 0;
+			if (!eglChooseConfig(display, configAttribs, &config, 1, &count) || count == 0) {
+				cout << "EGL: no usable config" << endl;
+				return false;
+			}
+			context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+			if (context == EGL_NO_CONTEXT) {
+				cout << "EGL: failed to create an OpenGL 3.3 core context" << endl;
+				return false;
+			}
+		}
+		if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			cout << "EGL: surfaceless make-current failed" << endl;
+			return false;
+		}
+		return true;
+	}
+
+	void destroy()
+	{
+		if (display == EGL_NO_DISPLAY) return;
+		eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+		eglTerminate(display);
+		display = EGL_NO_DISPLAY;
+		context = EGL_NO_CONTEXT;
+	}
+
+	static void* getProcAddress(const char* name)
+	{
+		return (void*)eglGetProcAddress(name);
+	}
+
+private:
+	EGLDisplay display = EGL_NO_DISPLAY;
+	EGLContext context = EGL_NO_CONTEXT;
+};
+#endif
+
+// RGBA8 color + depth renderbuffers to render into instead of a window
+class OffscreenTarget
+{
+public:
+	unsigned int fbo = 0;
+	int width = 0, height = 0;
+
+	bool create(int w, int h)
+	{
+		width = w; height = h;
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+		glGenRenderbuffers(2, rbo);
+		glBindRenderbuffer(GL_RENDERBUFFER, rbo[0]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo[0]);
+		glBindRenderbuffer(GL_RENDERBUFFER, rbo[1]);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo[1]);
+
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "Offscreen framebuffer is incomplete" << endl;
+			return false;
+		}
+		glViewport(0, 0, w, h);
+		return true;
+	}
+
+	// Reads the color buffer, top row first. Alpha is forced opaque, as a
+	// window would present it; blended decorations leave partial alpha.
+	void readPixels(vector<unsigned char>& pixels) const
+	{
+		pixels.resize((size_t)width * height * 4);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		for (size_t i = 3; i < pixels.size(); i += 4) pixels[i] = 255;
+
+		// GL origin is bottom-left
+		size_t row = (size_t)width * 4;
+		vector<unsigned char> tmp(row);
+		for (int y = 0; y < height / 2; y++) {
+			unsigned char* a = &pixels[y * row];
+			unsigned char* b = &pixels[(height - 1 - y) * row];
+			memcpy(tmp.data(), a, row); memcpy(a, b, row); memcpy(b, tmp.data(), row);
+		}
+	}
+
+private:
+	unsigned int rbo[2] = { 0, 0 };
+};
+
+inline bool writeFrame(const string& dir, int index, const string& format, int w, int h, const vector<unsigned char>& pixels)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "frame_%05d.%s", index, format == "raw" ? "rgba" : "png");
+	string path = dir + "/" + name;
+
+	if (format == "raw") {
+		ofstream f(path, ios::binary);
+		f.write((const char*)pixels.data(), pixels.size());
+		return (bool)f;
+	}
+	return stbi_write_png(path.c_str(), w, h, 4, pixels.data(), w * 4) != 0;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <queue>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+// Small worker pool for loading work (OBJ parsing, image decoding). Jobs
+// must not touch OpenGL: the context belongs to the main thread, which
+// polls the returned futures and does the uploads itself.
+class JobSystem
+{
+public:
+	~JobSystem() { stop(); }
+
+	void start(int threads)
+	{
+		if (!workers.empty()) return;
+		quit = false;
+		for (int i = 0; i < max(threads, 1); i++) {
+			workers.emplace_back([this]() { workerLoop(); });
+		}
+	}
+
+	// Finishes the queued jobs, then joins the workers
+	void stop()
+	{
+		{
+			lock_guard<mutex> lock(m);
+			quit = true;
+		}
+		cv.notify_all();
+		for (thread& t : workers) t.join();
+		workers.clear();
+	}
+
+	// Runs fn() on a worker. Exceptions end up in the future.
+	template<class Fn>
+	auto submit(Fn fn) -> future<decltype(fn())>
+	{
+		auto task = make_shared<packaged_task<decltype(fn())()>>(move(fn));
+		future<decltype(fn())> result = task->get_future();
+		{
+			lock_guard<mutex> lock(m);
+			jobs.push([task]() { (*task)(); });
+		}
+		cv.notify_one();
+		return result;
+	}
+
+private:
+	vector<thread> workers;
+	queue<function<void()>> jobs;
+	mutex m;
+	condition_variable cv;
+	bool quit = false;
+
+	void workerLoop()
+	{
+		for (;;) {
+			function<void()> job;
+			{
+				unique_lock<mutex> lock(m);
+				cv.wait(lock, [this]() { return quit || !jobs.empty(); });
+				if (jobs.empty()) return;
+				job = move(jobs.front());
+				jobs.pop();
+			}
+			job();
+		}
+	}
+};
+
+// True once the future holds a value (or an exception), without blocking
+template<class T>
+inline bool isReady(const future<T>& f)
+{
+	return f.valid() && f.wait_for(chrono::seconds(0)) == future_status::ready;
+}
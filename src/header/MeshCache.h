@@ -0,0 +1,227 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// Binary mesh cache written next to an OBJ (<obj>.meshcache).
+//
+// Layout: MeshCacheHeader, then raw little-endian blocks in this order:
+//   positions (float), normals (float), texcoords (float), indices (uint32)
+// Counts are in scalars, not vertices. Bump MESH_CACHE_VERSION whenever the
+// layout or the way Object builds its arrays changes.
+static const char MESH_CACHE_MAGIC[8] = { 'H', 'A', 'N', 'D', 'M', 'S', 'H', '\0' };
+static const uint32_t MESH_CACHE_VERSION = 1;
+
+enum MeshCacheFlags : uint32_t
+{
+	MESH_CACHE_INDEXED = 1u << 0,
+	MESH_CACHE_QUADS = 1u << 1
+};
+
+struct MeshCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint64_t sourceSize;
+	int64_t sourceMtime;
+	uint64_t sourceHash;
+	uint64_t positionCount;
+	uint64_t normalCount;
+	uint64_t texcoordCount;
+	uint64_t indexCount;
+};
+
+// Read-only view of a whole file: mmap on POSIX, plain read elsewhere
+class MappedFile
+{
+public:
+	MappedFile(const string& filename)
+	{
+#ifndef _WIN32
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) return;
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED) {
+				ptr = (const unsigned char*)p;
+				length = (size_t)st.st_size;
+			}
+		}
+		close(fd);
+#else
+		ifstream f(filename, ios::binary | ios::ate);
+		if (!f) return;
+		fallback.resize((size_t)f.tellg());
+		f.seekg(0);
+		f.read((char*)fallback.data(), fallback.size());
+		if (f) { ptr = fallback.data(); length = fallback.size(); }
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifndef _WIN32
+		if (ptr) munmap((void*)ptr, length);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* data() const { return ptr; }
+	size_t size() const { return length; }
+	bool valid() const { return ptr != NULL; }
+
+private:
+	const unsigned char* ptr = NULL;
+	size_t length = 0;
+#ifdef _WIN32
+	vector<unsigned char> fallback;
+#endif
+};
+
+// FNV-1a 64-bit
+inline uint64_t hashBytes(const unsigned char* data, size_t size)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++) {
+		h = (h ^ data[i]) * 1099511628211ULL;
+	}
+	return h;
+}
+
+inline bool statFile(const string& filename, uint64_t& size, int64_t& mtime)
+{
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0) return false;
+	size = (uint64_t)st.st_size;
+	mtime = (int64_t)st.st_mtime;
+	return true;
+}
+
+inline uint64_t hashFile(const string& filename)
+{
+	MappedFile file(filename);
+	return file.valid() ? hashBytes(file.data(), file.size()) : 0;
+}
+
+inline string meshCachePath(const string& objFilename)
+{
+	return objFilename + ".meshcache";
+}
+
+// Arrays that make up a cached mesh
+struct MeshCacheData
+{
+	vector<float> positions;
+	vector<float> normals;
+	vector<float> texcoords;
+	vector<unsigned int> indices;
+	uint32_t flags = 0;
+};
+
+// Loads the cache for `objFilename` if it is current. The cache is trusted
+// when size and mtime match; if only the mtime moved (checkout, copy) the
+// OBJ content hash decides. `stale` reports a hash-validated hit so the
+// caller can refresh the stored mtime. Malformed caches (block sizes that do
+// not fit each other or the file, indices past the last vertex) are rejected.
+inline bool readMeshCache(const string& objFilename, uint32_t wantedFlags, MeshCacheData& out, bool& stale)
+{
+	stale = false;
+	uint64_t srcSize; int64_t srcMtime;
+	if (!statFile(objFilename, srcSize, srcMtime)) return false;
+
+	MappedFile file(meshCachePath(objFilename));
+	if (!file.valid() || file.size() < sizeof(MeshCacheHeader)) return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0) return false;
+	if (header.version != MESH_CACHE_VERSION) return false;
+	if ((header.flags & MESH_CACHE_INDEXED) != (wantedFlags & MESH_CACHE_INDEXED)) return false;
+	if (header.sourceSize != srcSize) return false;
+
+	// The blocks must describe one mesh the way Object builds it: a normal and
+	// a uv per vertex, whole triangles, indices exactly when indexed. Counts
+	// are bounded by the file size first so the payload sum cannot wrap.
+	uint64_t maxCount = file.size() / sizeof(float);
+	if (header.positionCount > maxCount || header.indexCount > maxCount) return false;
+	uint64_t vertexCount = header.positionCount / 3;
+	if (header.positionCount % 3 != 0) return false;
+	if (header.normalCount != header.positionCount || header.texcoordCount != vertexCount * 2) return false;
+	if (header.flags & MESH_CACHE_INDEXED) {
+		if (header.indexCount == 0 || header.indexCount % 3 != 0) return false;
+	} else {
+		if (header.indexCount != 0 || header.positionCount % 9 != 0) return false;
+	}
+	uint64_t payload = (header.positionCount + header.normalCount + header.texcoordCount) * sizeof(float)
+		+ header.indexCount * sizeof(uint32_t);
+	if (file.size() != sizeof(MeshCacheHeader) + payload) return false;
+
+	if (header.sourceMtime != srcMtime) {
+		if (hashFile(objFilename) != header.sourceHash) return false;
+		stale = true;
+	}
+
+	const unsigned char* p = file.data() + sizeof(MeshCacheHeader);
+	auto readBlock = [&p](auto& dst, uint64_t count) {
+		dst.resize((size_t)count);
+		if (count) memcpy(dst.data(), p, (size_t)count * sizeof(dst[0]));
+		p += count * sizeof(dst[0]);
+	};
+	readBlock(out.positions, header.positionCount);
+	readBlock(out.normals, header.normalCount);
+	readBlock(out.texcoords, header.texcoordCount);
+	readBlock(out.indices, header.indexCount);
+	for (unsigned int index : out.indices) {
+		if (index >= vertexCount) return false;
+	}
+	out.flags = header.flags;
+	return true;
+}
+
+// Writes the cache through a temp file + rename so an interrupted run never
+// leaves a half-written cache behind.
+inline bool writeMeshCache(const string& objFilename, const MeshCacheData& mesh)
+{
+	MeshCacheHeader header;
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.flags = mesh.flags;
+	if (!statFile(objFilename, header.sourceSize, header.sourceMtime)) return false;
+	header.sourceHash = hashFile(objFilename);
+	header.positionCount = mesh.positions.size();
+	header.normalCount = mesh.normals.size();
+	header.texcoordCount = mesh.texcoords.size();
+	header.indexCount = mesh.indices.size();
+
+	string path = meshCachePath(objFilename);
+	string tmpPath = path + ".tmp";
+	{
+		ofstream f(tmpPath, ios::binary | ios::trunc);
+		if (!f) return false;
+		f.write((const char*)&header, sizeof(header));
+		f.write((const char*)mesh.positions.data(), mesh.positions.size() * sizeof(float));
+		f.write((const char*)mesh.normals.data(), mesh.normals.size() * sizeof(float));
+		f.write((const char*)mesh.texcoords.data(), mesh.texcoords.size() * sizeof(float));
+		f.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+		if (!f) { f.close(); remove(tmpPath.c_str()); return false; }
+	}
+#ifdef _WIN32
+	remove(path.c_str());
+#endif
+	return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
@@ -1,9 +1,14 @@
+#pragma once
 #include <vector>
 #include <string>
+#include <cstring>
 #include <iostream>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 #include <tiny_obj_loader.h>
+#include "VertexLayout.h"
+#include "MeshCache.h"
 
 using namespace std;
 
@@ -13,29 +18,321 @@ enum class FACETYPE
 	QUAD
 };
 
+struct ObjectLoadOptions
+{
+	bool indexed = false;  // weld vertices and fill `indices`
+	bool useCache = false; // read/write <obj>.meshcache instead of re-parsing
+	bool parallelParse = false; // tokenize the OBJ on worker threads
+	int parseThreads = 0;       // 0 = hardware concurrency
+};
+
+// A run of consecutive draw elements (indices, or vertices when not indexed)
+struct IndexRange
+{
+	GLint first = 0;
+	GLsizei count = 0;
+};
+
 class Object
 {
 public:
 	vector<float> positions;
 	vector<float> normals;
 	vector<float> texcoords;
+	vector<unsigned int> indices; // only filled in indexed mode
+	vector<unsigned char> tags;   // optional integer per vertex, e.g. the hand region (HandRegions.h)
 	FACETYPE faceType = FACETYPE::TRIANGLE;
+	bool indexed = false;
+	vector<IndexRange> regions; // filled by partitionTriangles(), one per region id
 
-	Object(const string& filename)
+	// useIndices = true welds identical (position, normal, uv) corners into
+	// unique vertices and fills `indices` for glDrawElements.
+	Object(const string& filename, bool useIndices = false) : indexed(useIndices)
 	{
 		loadOBJ(filename);
+		if (indexed) {
+			weldVertices();
+		}
+	}
+
+	Object(const string& filename, const ObjectLoadOptions& options) : indexed(options.indexed)
+	{
+		if (options.useCache && loadMeshCache(filename)) {
+			return;
+		}
+		loadOBJ(filename, options);
+		if (indexed) {
+			weldVertices();
+		}
+		if (options.useCache) {
+			saveMeshCache(filename);
+		}
+	}
+
+	// Construct directly from an already loaded cache block
+	Object(MeshCacheData&& mesh) : indexed((mesh.flags & MESH_CACHE_INDEXED) != 0)
+	{
+		assignMesh(std::move(mesh));
+	}
+
+	// Number of vertices (non-indexed) or indices (indexed) to draw
+	GLsizei drawCount() const
+	{
+		return indexed ? (GLsizei)indices.size() : (GLsizei)(positions.size() / 3);
+	}
+
+	size_t triangleCount() const
+	{
+		return (size_t)drawCount() / 3;
+	}
+
+	// Vertex id of corner k (0..2) of triangle t, for both storage modes
+	unsigned int triangleVertex(size_t t, int k) const
+	{
+		return indexed ? indices[t * 3 + k] : (unsigned int)(t * 3 + k);
+	}
+
+	// Reorders the triangles so each region is one contiguous range, in
+	// region order, keeping the original order inside a region. `region`
+	// holds one id in [0, regionCount) per triangle.
+	void partitionTriangles(const vector<int>& region, int regionCount)
+	{
+		size_t triangles = triangleCount();
+		vector<size_t> start(regionCount + 1, 0);
+		for (size_t t = 0; t < triangles; t++) start[region[t] + 1]++;
+		for (int r = 0; r < regionCount; r++) start[r + 1] += start[r];
+
+		regions.assign(regionCount, IndexRange());
+		for (int r = 0; r < regionCount; r++) {
+			regions[r].first = (GLint)(start[r] * 3);
+			regions[r].count = (GLsizei)((start[r + 1] - start[r]) * 3);
+		}
+
+		vector<size_t> order(triangles);
+		for (size_t t = 0; t < triangles; t++) order[start[region[t]]++] = t;
+
+		if (indexed) {
+			vector<unsigned int> sorted(indices.size());
+			for (size_t i = 0; i < triangles; i++) {
+				memcpy(&sorted[i * 3], &indices[order[i] * 3], 3 * sizeof(unsigned int));
+			}
+			indices.swap(sorted);
+		} else {
+			auto permute = [&order, triangles](vector<float>& data, size_t width) {
+				if (data.empty()) return;
+				vector<float> sorted(data.size());
+				size_t stride = width * 3;
+				for (size_t i = 0; i < triangles; i++) {
+					memcpy(&sorted[i * stride], &data[order[i] * stride], stride * sizeof(float));
+				}
+				data.swap(sorted);
+			};
+			permute(positions, 3);
+			permute(normals, 3);
+			permute(texcoords, 2);
+			if (!tags.empty()) {
+				vector<unsigned char> sorted(tags.size());
+				for (size_t i = 0; i < triangles; i++) {
+					memcpy(&sorted[i * 3], &tags[order[i] * 3], 3);
+				}
+				tags.swap(sorted);
+			}
+		}
+	}
+
+	// Appends a copy of vertex v (all attributes) and returns its id
+	unsigned int duplicateVertex(unsigned int v)
+	{
+		unsigned int copy = (unsigned int)(positions.size() / 3);
+		for (int k = 0; k < 3; k++) positions.push_back(positions[v * 3 + k]);
+		if (!normals.empty()) for (int k = 0; k < 3; k++) normals.push_back(normals[v * 3 + k]);
+		if (!texcoords.empty()) for (int k = 0; k < 2; k++) texcoords.push_back(texcoords[v * 2 + k]);
+		if (!tags.empty()) tags.push_back(tags[v]);
+		return copy;
+	}
+
+	// 16-bit indices are enough as long as every vertex id fits in a ushort
+	GLenum indexType() const
+	{
+		return (positions.size() / 3 <= 0xFFFF) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	}
+
+	// True when every uv fits USHORT2_NORM without clamping
+	bool texcoordsInUnitRange() const
+	{
+		for (float t : texcoords) {
+			if (t < 0.0f || t > 1.0f) return false;
+		}
+		return true;
+	}
+
+	// Pack positions/normals/texcoords into a single interleaved buffer
+	// following `layout` (one vertex = layout.stride bytes).
+	vector<unsigned char> interleave(const VertexLayout& layout) const
+	{
+		size_t vertexCount = positions.size() / 3;
+		vector<unsigned char> data(vertexCount * layout.stride);
+
+		for (size_t i = 0; i < vertexCount; i++) {
+			unsigned char* vertex = &data[i * layout.stride];
+			for (const auto& a : layout.attribs) {
+				unsigned char* dst = vertex + a.offset;
+				if (a.source == ATTRIBSOURCE::TAG) {
+					dst[0] = tags.empty() ? 0 : tags[i];
+					continue; // UBYTE_INT is the only tag format; padding stays zero
+				}
+
+				float src[3] = { 0.0f, 0.0f, 0.0f };
+				if (a.source == ATTRIBSOURCE::POSITION) {
+					memcpy(src, &positions[i * 3], 3 * sizeof(float));
+				} else if (a.source == ATTRIBSOURCE::NORMAL) {
+					memcpy(src, &normals[i * 3], 3 * sizeof(float));
+				} else {
+					memcpy(src, &texcoords[i * 2], 2 * sizeof(float));
+				}
+
+				switch (a.format) {
+					case ATTRIBFORMAT::FLOAT3:
+						memcpy(dst, src, 3 * sizeof(float));
+						break;
+					case ATTRIBFORMAT::FLOAT2:
+						memcpy(dst, src, 2 * sizeof(float));
+						break;
+					case ATTRIBFORMAT::INT_2_10_10_10: {
+						float len = sqrtf(src[0] * src[0] + src[1] * src[1] + src[2] * src[2]);
+						if (len > 0.0f) { src[0] /= len; src[1] /= len; src[2] /= len; }
+						uint32_t packed = packNormal2_10_10_10(src[0], src[1], src[2]);
+						memcpy(dst, &packed, 4);
+						break;
+					}
+					case ATTRIBFORMAT::HALF2: {
+						uint16_t packed[2] = { floatToHalf(src[0]), floatToHalf(src[1]) };
+						memcpy(dst, packed, 4);
+						break;
+					}
+					case ATTRIBFORMAT::USHORT2_NORM: {
+						uint16_t packed[2] = { packUnorm16(src[0]), packUnorm16(src[1]) };
+						memcpy(dst, packed, 4);
+						break;
+					}
+					case ATTRIBFORMAT::UBYTE_INT:
+						break;
+				}
+			}
+		}
+		return data;
 	}
 
 private:
 	unsigned int VAO;
 	int vertex_cnt;
 
-	void loadOBJ(const string& filename) {
+	void assignMesh(MeshCacheData&& mesh)
+	{
+		positions.swap(mesh.positions);
+		normals.swap(mesh.normals);
+		texcoords.swap(mesh.texcoords);
+		indices.swap(mesh.indices);
+		faceType = (mesh.flags & MESH_CACHE_QUADS) ? FACETYPE::QUAD : FACETYPE::TRIANGLE;
+	}
+
+	bool loadMeshCache(const string& filename)
+	{
+		MeshCacheData mesh;
+		bool stale = false;
+		if (!readMeshCache(filename, indexed ? MESH_CACHE_INDEXED : 0u, mesh, stale)) {
+			return false;
+		}
+		assignMesh(std::move(mesh));
+		cout << "Loaded mesh cache: " << meshCachePath(filename) << endl;
+		if (stale) {
+			saveMeshCache(filename); // content unchanged, refresh the stored mtime
+		}
+		return true;
+	}
+
+	void saveMeshCache(const string& filename) const
+	{
+		if (positions.empty()) return;
+		MeshCacheData mesh;
+		mesh.positions = positions;
+		mesh.normals = normals;
+		mesh.texcoords = texcoords;
+		mesh.indices = indices;
+		mesh.flags = (indexed ? MESH_CACHE_INDEXED : 0u) | (faceType == FACETYPE::QUAD ? MESH_CACHE_QUADS : 0u);
+		if (!writeMeshCache(filename, mesh)) {
+			cerr << "Failed to write mesh cache: " << meshCachePath(filename) << endl;
+		}
+	}
+
+	// One expanded corner: position(3) + normal(3) + texcoord(2), compared bitwise
+	struct VertexKey
+	{
+		float v[8];
+		bool operator==(const VertexKey& o) const { return memcmp(v, o.v, sizeof(v)) == 0; }
+	};
+
+	struct VertexKeyHash
+	{
+		size_t operator()(const VertexKey& k) const
+		{
+			// FNV-1a over the raw bytes
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(k.v);
+			size_t h = 14695981039346656037ULL;
+			for (size_t i = 0; i < sizeof(k.v); i++) {
+				h = (h ^ p[i]) * 1099511628211ULL;
+			}
+			return h;
+		}
+	};
+
+	// Collapse the flat triangle soup produced by loadOBJ into unique vertices
+	// plus an index buffer. Triangle order and winding are preserved, so the
+	// rendered triangles are identical to the non-indexed path.
+	void weldVertices() {
+		size_t cornerCount = positions.size() / 3;
+		vector<float> uniquePositions, uniqueNormals, uniqueTexcoords;
+		unordered_map<VertexKey, unsigned int, VertexKeyHash> cache;
+		cache.reserve(cornerCount);
+		indices.clear();
+		indices.reserve(cornerCount);
+
+		for (size_t i = 0; i < cornerCount; i++) {
+			VertexKey key;
+			memcpy(&key.v[0], &positions[i * 3], 3 * sizeof(float));
+			memcpy(&key.v[3], &normals[i * 3], 3 * sizeof(float));
+			memcpy(&key.v[6], &texcoords[i * 2], 2 * sizeof(float));
+
+			auto it = cache.find(key);
+			if (it != cache.end()) {
+				indices.push_back(it->second);
+				continue;
+			}
+
+			unsigned int idx = (unsigned int)(uniquePositions.size() / 3);
+			uniquePositions.insert(uniquePositions.end(), key.v, key.v + 3);
+			uniqueNormals.insert(uniqueNormals.end(), key.v + 3, key.v + 6);
+			uniqueTexcoords.insert(uniqueTexcoords.end(), key.v + 6, key.v + 8);
+			cache.emplace(key, idx);
+			indices.push_back(idx);
+		}
+
+		cout << "Welded " << cornerCount << " corners into " << uniquePositions.size() / 3
+			<< " vertices (" << indices.size() / 3 << " triangles)" << endl;
+
+		positions.swap(uniquePositions);
+		normals.swap(uniqueNormals);
+		texcoords.swap(uniqueTexcoords);
+	}
+
+	void loadOBJ(const string& filename, const ObjectLoadOptions& options = ObjectLoadOptions()) {
 		vector<tinyobj::shape_t> shapes;
 		vector<tinyobj::material_t> materials;
 		string err;
 
-		bool ret = tinyobj::LoadObj(shapes, materials, err, filename.c_str());
+		bool ret = options.parallelParse
+			? tinyobj::LoadObjParallel(shapes, materials, err, filename.c_str(), NULL, true, options.parseThreads)
+			: tinyobj::LoadObj(shapes, materials, err, filename.c_str());
 
 		if (!err.empty()) {
 			cerr << "Error loading OBJ: " << err << endl;
@@ -0,0 +1,315 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <glad/glad.h>
+
+using namespace std;
+
+// Phases of one frame. CPU time is measured for all of them; the draw
+// passes additionally get a GL_TIME_ELAPSED query around their GL calls.
+enum PROFILEPHASE
+{
+	PROFILE_UPDATE,     // simulation steps + matrices + UBO upload
+	PROFILE_BACKGROUND, // wood background pass
+	PROFILE_HAND,       // hand + geometry shader decorations
+	PROFILE_SWAP,       // buffer swap / readback
+	PROFILE_PACING,     // frame limiter / low-latency wait (FramePacer)
+	PROFILE_PHASE_COUNT
+};
+
+inline const char* profilePhaseName(int phase)
+{
+	static const char* names[PROFILE_PHASE_COUNT] = { "update", "background", "hand", "swap", "pacing" };
+	return names[phase];
+}
+
+inline bool profilePhaseHasGPU(int phase)
+{
+	return phase == PROFILE_BACKGROUND || phase == PROFILE_HAND;
+}
+
+// Fixed-size window of the most recent samples (milliseconds)
+class RollingStats
+{
+public:
+	explicit RollingStats(size_t capacity = 240) : samples(capacity, 0.0) {}
+
+	void add(double ms)
+	{
+		samples[head] = ms;
+		head = (head + 1) % samples.size();
+		if (count < samples.size()) count++;
+	}
+
+	size_t size() const { return count; }
+
+	void summarize(double& minMs, double& avgMs, double& p99Ms) const
+	{
+		minMs = avgMs = p99Ms = 0.0;
+		if (count == 0) return;
+		vector<double> sorted(samples.begin(), samples.begin() + count);
+		sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double v : sorted) sum += v;
+		minMs = sorted.front();
+		avgMs = sum / count;
+		p99Ms = sorted[min(count - 1, (size_t)(0.99 * (count - 1) + 0.5))];
+	}
+
+private:
+	vector<double> samples;
+	size_t head = 0;
+	size_t count = 0;
+};
+
+// Per-phase CPU timers and GPU timer queries, aggregated over the last few
+// hundred frames and optionally recorded into a Chrome trace
+// (chrome://tracing or ui.perfetto.dev).
+//
+// GPU results arrive a few frames late, so every GPU phase owns a ring of
+// GPU_LATENCY queries. A query is only read back once
+// GL_QUERY_RESULT_AVAILABLE says so, so the profiler never stalls the
+// pipeline. GL_TIME_ELAPSED queries cannot nest; the GPU phases must be
+// sequential, which they are.
+class FrameProfiler
+{
+public:
+	static const int GPU_LATENCY = 4;
+
+	bool enabled = true;
+
+	void create()
+	{
+		for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+			if (profilePhaseHasGPU(p)) {
+				glGenQueries(GPU_LATENCY, gpu[p].queries);
+			}
+		}
+		epoch = chrono::steady_clock::now();
+		created = true;
+	}
+
+	void destroy()
+	{
+		if (!created) return;
+		for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+			if (profilePhaseHasGPU(p)) {
+				glDeleteQueries(GPU_LATENCY, gpu[p].queries);
+			}
+		}
+		created = false;
+	}
+
+	// Starts a frame: collects whichever GPU results have landed since
+	void beginFrame()
+	{
+		if (!enabled || !created) return;
+		collectGPU(false);
+		frameStart = nowMicros();
+		frameIndex++;
+	}
+
+	void endFrame()
+	{
+		if (!enabled || !created) return;
+		double frameMs = (nowMicros() - frameStart) / 1000.0;
+		frameStats.add(frameMs);
+		if (recordFrames > 0) {
+			trace.push_back({ "frame", 0, frameStart, frameMs * 1000.0 });
+			if (--recordFrames == 0) {
+				collectGPU(true);
+				writeTrace();
+			}
+		}
+	}
+
+	void begin(int phase)
+	{
+		if (!enabled || !created) return;
+		cpuStart[phase] = nowMicros();
+		if (profilePhaseHasGPU(phase)) {
+			GPURing& ring = gpu[phase];
+			int slot = ring.next;
+			if (ring.pending[slot]) {
+				// Oldest result still in flight: drop it instead of blocking
+				ring.pending[slot] = false;
+			}
+			glBeginQuery(GL_TIME_ELAPSED, ring.queries[slot]);
+			ring.submitMicros[slot] = cpuStart[phase];
+			ring.recorded[slot] = recordFrames > 0;
+		}
+	}
+
+	void end(int phase)
+	{
+		if (!enabled || !created) return;
+		double start = cpuStart[phase];
+		double dur = nowMicros() - start;
+		cpu[phase].add(dur / 1000.0);
+		if (recordFrames > 0) {
+			trace.push_back({ profilePhaseName(phase), 1, start, dur });
+		}
+		if (profilePhaseHasGPU(phase)) {
+			GPURing& ring = gpu[phase];
+			glEndQuery(GL_TIME_ELAPSED);
+			ring.pending[ring.next] = true;
+			ring.next = (ring.next + 1) % GPU_LATENCY;
+		}
+	}
+
+	// Time from input sampling to the present (FramePacer::framePresented)
+	void addInputAge(double ms)
+	{
+		if (!enabled || !created) return;
+		inputAge.add(ms);
+	}
+
+	// Records the next `frames` frames and writes them to `path` as a
+	// Chrome trace once they are done.
+	void captureTrace(const string& path, int frames)
+	{
+		tracePath = path;
+		trace.clear();
+		recordFrames = frames;
+		cout << "Profiler: capturing " << frames << " frames to " << path << endl;
+	}
+
+	// Flushes a capture that was cut short (e.g. the app is exiting)
+	void finishTrace()
+	{
+		if (recordFrames > 0) {
+			recordFrames = 0;
+			collectGPU(true);
+			writeTrace();
+		}
+	}
+
+	void printStats() const
+	{
+		double mn, avg, p99;
+		frameStats.summarize(mn, avg, p99);
+		printf("Frame  %-11s min %7.3f  avg %7.3f  p99 %7.3f ms  (%zu frames)\n", "total", mn, avg, p99, frameStats.size());
+		for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+			cpu[p].summarize(mn, avg, p99);
+			printf("CPU    %-11s min %7.3f  avg %7.3f  p99 %7.3f ms\n", profilePhaseName(p), mn, avg, p99);
+		}
+		for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+			if (!profilePhaseHasGPU(p)) continue;
+			gpu[p].stats.summarize(mn, avg, p99);
+			printf("GPU    %-11s min %7.3f  avg %7.3f  p99 %7.3f ms\n", profilePhaseName(p), mn, avg, p99);
+		}
+		if (inputAge.size() > 0) {
+			inputAge.summarize(mn, avg, p99);
+			printf("Input  %-11s min %7.3f  avg %7.3f  p99 %7.3f ms\n", "to present", mn, avg, p99);
+		}
+		fflush(stdout);
+	}
+
+private:
+	struct TraceEvent
+	{
+		const char* name;
+		int tid;          // 0 = frame, 1 = CPU phases, 2 = GPU phases
+		double ts, dur;   // microseconds since create()
+	};
+
+	struct GPURing
+	{
+		GLuint queries[GPU_LATENCY] = {};
+		bool pending[GPU_LATENCY] = {};
+		bool recorded[GPU_LATENCY] = {};
+		double submitMicros[GPU_LATENCY] = {};
+		int next = 0;
+		RollingStats stats;
+	};
+
+	RollingStats frameStats;
+	RollingStats inputAge;
+	RollingStats cpu[PROFILE_PHASE_COUNT];
+	GPURing gpu[PROFILE_PHASE_COUNT];
+	double cpuStart[PROFILE_PHASE_COUNT] = {};
+	double frameStart = 0.0;
+	uint64_t frameIndex = 0;
+	bool created = false;
+	chrono::steady_clock::time_point epoch;
+
+	vector<TraceEvent> trace;
+	string tracePath;
+	int recordFrames = 0;
+
+	double nowMicros() const
+	{
+		return chrono::duration<double, micro>(chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Reads back finished queries, oldest first. `wait` blocks on the ones
+	// still in flight (only used when a trace capture ends).
+	void collectGPU(bool wait)
+	{
+		for (int p = 0; p < PROFILE_PHASE_COUNT; p++) {
+			if (!profilePhaseHasGPU(p)) continue;
+			GPURing& ring = gpu[p];
+			for (int i = 0; i < GPU_LATENCY; i++) {
+				int slot = (ring.next + i) % GPU_LATENCY;
+				if (!ring.pending[slot]) continue;
+				if (!wait) {
+					GLint available = 0;
+					glGetQueryObjectiv(ring.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+					if (!available) break; // later ones cannot be ready either
+				}
+				GLuint64 ns = 0;
+				glGetQueryObjectui64v(ring.queries[slot], GL_QUERY_RESULT, &ns);
+				ring.pending[slot] = false;
+				ring.stats.add(ns / 1.0e6);
+				// The GPU has no shared clock with the CPU here, so the event is
+				// placed at the CPU submit time of its pass.
+				if (ring.recorded[slot]) {
+					trace.push_back({ profilePhaseName(p), 2, ring.submitMicros[slot], ns / 1000.0 });
+				}
+			}
+		}
+	}
+
+	void writeTrace()
+	{
+		ofstream f(tracePath);
+		if (!f) {
+			cout << "Profiler: cannot write " << tracePath << endl;
+			return;
+		}
+		f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frame\"}},\n";
+		f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+		f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU (GL_TIME_ELAPSED)\"}}";
+		char line[256];
+		for (const TraceEvent& e : trace) {
+			snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				e.name, e.tid == 2 ? "gpu" : "cpu", e.tid, e.ts, e.dur);
+			f << line;
+		}
+		f << "\n]}\n";
+		cout << "Profiler: wrote " << trace.size() << " events to " << tracePath << endl;
+		trace.clear();
+	}
+};
+
+// Times a phase for the lifetime of the scope
+class ProfileScope
+{
+public:
+	ProfileScope(FrameProfiler& p, int phase) : profiler(p), phase(phase) { profiler.begin(phase); }
+	~ProfileScope() { profiler.end(phase); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	FrameProfiler& profiler;
+	int phase;
+};
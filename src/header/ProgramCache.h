@@ -0,0 +1,151 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <glad/glad.h>
+#include "MeshCache.h"
+
+using namespace std;
+
+// On-disk cache of linked programs (glGetProgramBinary), one file per
+// program: <dir>/<name>.programcache.
+//
+// Layout: ProgramCacheHeader, then the driver's binary blob. The key hashes
+// GL_VENDOR / GL_RENDERER / GL_VERSION and every stage's type and source, so
+// a driver update or an edited shader simply misses and the program is
+// compiled again. Drivers may still reject a blob (glProgramBinary fails to
+// link); that is treated as a miss too.
+static const char PROGRAM_CACHE_MAGIC[8] = { 'H', 'A', 'N', 'D', 'P', 'R', 'G', '\0' };
+static const uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct ProgramCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t binaryFormat;
+	uint64_t key;
+	uint64_t binarySize;
+};
+
+// One stage of a program, source already read from disk
+struct ShaderSource
+{
+	GLenum type;
+	string code;
+};
+
+class ProgramCache
+{
+public:
+	bool enabled = true;
+	int hits = 0, misses = 0;
+
+	// Needs a current context. Disables itself when the driver offers no
+	// binary formats (GL < 4.1 without ARB_get_program_binary, or none).
+	void init(const string& directory)
+	{
+		dir = directory;
+		GLint formats = 0;
+		if ((GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) && glProgramBinary && glGetProgramBinary) {
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		}
+		supported = formats > 0;
+
+		string driver;
+		for (GLenum e : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+			const GLubyte* s = glGetString(e);
+			driver += s ? (const char*)s : "";
+			driver += '\n';
+		}
+		driverHash = hashBytes((const unsigned char*)driver.data(), driver.size());
+	}
+
+	bool active() const { return enabled && supported; }
+
+	uint64_t key(const vector<ShaderSource>& stages) const
+	{
+		uint64_t h = driverHash;
+		for (const ShaderSource& s : stages) {
+			h = (h ^ s.type) * 1099511628211ULL;
+			h ^= hashBytes((const unsigned char*)s.code.data(), s.code.size());
+			h *= 1099511628211ULL;
+		}
+		return h;
+	}
+
+	// Linked program restored from the cache, or 0 on a miss
+	unsigned int load(const string& name, uint64_t key)
+	{
+		if (!active()) return 0;
+		MappedFile file(path(name));
+		unsigned int program = 0;
+		if (file.valid() && file.size() >= sizeof(ProgramCacheHeader)) {
+			ProgramCacheHeader header;
+			memcpy(&header, file.data(), sizeof(header));
+			if (memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0
+				&& header.version == PROGRAM_CACHE_VERSION && header.key == key
+				&& file.size() == sizeof(ProgramCacheHeader) + header.binarySize) {
+				program = glCreateProgram();
+				glProgramBinary(program, header.binaryFormat, file.data() + sizeof(ProgramCacheHeader), (GLsizei)header.binarySize);
+				GLint linked = 0;
+				glGetProgramiv(program, GL_LINK_STATUS, &linked);
+				if (!linked) {
+					glDeleteProgram(program);
+					program = 0;
+				}
+			}
+		}
+		if (program) hits++; else misses++;
+		return program;
+	}
+
+	// Call before glLinkProgram so the driver keeps the binary around
+	void prepare(unsigned int program) const
+	{
+		if (active()) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// Writes through a temp file + rename like the mesh cache
+	bool store(const string& name, uint64_t key, unsigned int program) const
+	{
+		if (!active() || program == 0) return false;
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0) return false;
+		vector<unsigned char> binary(length);
+		GLenum format = 0;
+		glGetProgramBinary(program, length, &length, &format, binary.data());
+
+		ProgramCacheHeader header;
+		memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+		header.version = PROGRAM_CACHE_VERSION;
+		header.binaryFormat = format;
+		header.key = key;
+		header.binarySize = (uint64_t)length;
+
+		string target = path(name);
+		string tmpPath = target + ".tmp";
+		{
+			ofstream f(tmpPath, ios::binary | ios::trunc);
+			if (!f) return false;
+			f.write((const char*)&header, sizeof(header));
+			f.write((const char*)binary.data(), length);
+			if (!f) { f.close(); remove(tmpPath.c_str()); return false; }
+		}
+#ifdef _WIN32
+		remove(target.c_str());
+#endif
+		return rename(tmpPath.c_str(), target.c_str()) == 0;
+	}
+
+private:
+	string dir;
+	bool supported = false;
+	uint64_t driverHash = 0;
+
+	string path(const string& name) const { return dir + name + ".programcache"; }
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include "Shader.h"
+#include "RenderState.h"
+
+using namespace std;
+
+// Passes, in drawing order (top two bits of the sort key)
+enum class RENDERLAYER
+{
+	BACKGROUND = 0,  // full-screen quads, no depth writes
+	SOLID = 1,       // opaque: sorted by state, then front to back
+	TRANSLUCENT = 2  // blended: sorted back to front, then by state
+};
+
+// One draw call plus the state it needs. Uniforms shared by a pass (the
+// FrameData UBO) are not part of it; per-item ones are set by setUniforms.
+struct DrawItem
+{
+	RENDERLAYER layer = RENDERLAYER::SOLID;
+	ShaderProgram* program = NULL;
+	GLuint vao = 0;
+	GLuint texture = 0;     // 2D texture for `textureUnit`, 0 = leave as is
+	int textureUnit = 0;
+	bool depthWrite = true;
+	float depth = 0.0f;     // view-space distance of the item
+
+	// glDrawElements when indexType is set (first counts indices), else
+	// glDrawArrays; instanced when instances > 0
+	GLint first = 0;
+	GLsizei count = 0;
+	GLenum indexType = 0;
+	GLsizei instances = 0;
+
+	const float* mvp = NULL;   // uploaded as "mvp" when set; must outlive the frame
+	void (*setUniforms)(ShaderProgram& program, const DrawItem& item) = NULL;
+	float params[4] = {};      // free for setUniforms
+};
+
+// Per-frame list of draw items. Each item gets a 64-bit key:
+//
+//   SOLID        layer:2 | program:12 | texture:12 | vao:12 | depth:24
+//   TRANSLUCENT  layer:2 | ~depth:24 | program:12 | texture:12 | vao:12
+//
+// so sorting groups opaque items by state (front to back inside a group,
+// for early depth rejection) and draws blended ones back to front. GL
+// names are truncated to 12 bits; a collision only costs a state change.
+// Depth uses the top 24 bits of the float, which order like the value for
+// non-negative floats.
+//
+// The sort is an LSD radix sort over (key, index) pairs, 8 bits per pass,
+// with all eight histograms built in one read. Passes whose byte is the
+// same for every item are skipped. Queues under RADIX_MIN_ITEMS (one hand
+// is under ten items) use a stable comparison sort instead: below about a
+// thousand items it beats clearing and scanning the histograms
+// (ICG_2025_HW2_selftest render-queue prints both timings).
+class RenderQueue
+{
+public:
+	void clear()
+	{
+		items.clear();
+		sorted = false;
+	}
+
+	void submit(const DrawItem& item)
+	{
+		if (item.count == 0 || item.program == NULL) return;
+		items.push_back(item);
+		sorted = false;
+	}
+
+	size_t size() const { return items.size(); }
+
+	static const size_t RADIX_MIN_ITEMS = 1024;
+
+	// The key an item is sorted by (layout above)
+	static uint64_t sortKey(const DrawItem& item)
+	{
+		uint64_t state = ((uint64_t)(item.program->id & 0xFFF) << 24)
+			| ((uint64_t)(item.texture & 0xFFF) << 12) | (uint64_t)(item.vao & 0xFFF);
+		uint64_t depth = depthBits(item.depth);
+		uint64_t key = (uint64_t)item.layer << 62;
+		if (item.layer == RENDERLAYER::TRANSLUCENT) return key | ((~depth & 0xFFFFFF) << 36) | state;
+		return key | (state << 24) | depth;
+	}
+
+	// Radix passes the last sort() needed (0-8, 0 for a comparison sort)
+	int sortPasses() const { return passes; }
+
+	void sort()
+	{
+		size_t n = items.size();
+		entries.resize(n);
+		scratch.resize(n);
+		for (size_t i = 0; i < n; i++) entries[i] = { sortKey(items[i]), (uint32_t)i };
+		passes = 0;
+		sorted = true;
+		if (n < RADIX_MIN_ITEMS) {
+			stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+			return;
+		}
+
+		uint32_t histogram[8][256];
+		memset(histogram, 0, sizeof(histogram));
+		for (const Entry& e : entries) {
+			for (int b = 0; b < 8; b++) histogram[b][(e.key >> (8 * b)) & 0xFF]++;
+		}
+		for (int b = 0; b < 8; b++) {
+			uint32_t* h = histogram[b];
+			if (h[(entries[0].key >> (8 * b)) & 0xFF] == n) continue;
+			uint32_t offset = 0;
+			for (int v = 0; v < 256; v++) {
+				uint32_t c = h[v];
+				h[v] = offset;
+				offset += c;
+			}
+			for (const Entry& e : entries) scratch[h[(e.key >> (8 * b)) & 0xFF]++] = e;
+			entries.swap(scratch);
+			passes++;
+		}
+	}
+
+	// Submission indices of all items in draw order (sorts first if needed)
+	vector<uint32_t> drawOrder()
+	{
+		if (!sorted) sort();
+		vector<uint32_t> order;
+		order.reserve(entries.size());
+		for (const Entry& e : entries) order.push_back(e.index);
+		return order;
+	}
+
+	// Draws the items of one layer in key order (sort() first)
+	void draw(RENDERLAYER layer)
+	{
+		if (!sorted) sort();
+		uint64_t layerKey = (uint64_t)layer << 62;
+		auto it = lower_bound(entries.begin(), entries.end(), layerKey,
+			[](const Entry& e, uint64_t key) { return e.key < key; });
+		for (; it != entries.end() && (it->key >> 62) == (uint64_t)layer; ++it) {
+			execute(items[it->index]);
+		}
+	}
+
+private:
+	struct Entry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	vector<DrawItem> items;
+	vector<Entry> entries, scratch;
+	bool sorted = false;
+	int passes = 0;
+
+	static uint64_t depthBits(float depth)
+	{
+		if (!(depth > 0.0f)) depth = 0.0f;
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		return bits >> 8;
+	}
+
+	static void execute(const DrawItem& item)
+	{
+		RenderState& state = RenderState::current();
+		state.depthMask(item.depthWrite);
+		state.useProgram(*item.program);
+		state.bindVertexArray(item.vao);
+		if (item.texture) state.bindTexture(item.textureUnit, item.texture);
+		static const ShaderProgram::UniformId mvp = ShaderProgram::uniform("mvp");
+		if (item.mvp) item.program->setMat4(mvp, item.mvp);
+		if (item.setUniforms) item.setUniforms(*item.program, item);
+
+		if (item.indexType) {
+			size_t indexSize = item.indexType == GL_UNSIGNED_BYTE ? 1 : item.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+			const void* offset = (const void*)(uintptr_t)(item.first * indexSize);
+			if (item.instances > 0) glDrawElementsInstanced(GL_TRIANGLES, item.count, item.indexType, offset, item.instances);
+			else glDrawElements(GL_TRIANGLES, item.count, item.indexType, offset);
+		} else {
+			if (item.instances > 0) glDrawArraysInstanced(GL_TRIANGLES, item.first, item.count, item.instances);
+			else glDrawArrays(GL_TRIANGLES, item.first, item.count);
+		}
+	}
+};
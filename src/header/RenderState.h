@@ -0,0 +1,112 @@
+#pragma once
+#include <glad/glad.h>
+#include "Shader.h"
+
+using namespace std;
+
+// Shadow copy of the GL bindings and fixed-function state the renderer
+// touches. Every setter compares against the last value it issued and
+// drops no-op calls, counting both in ShaderProgram::stats().
+//
+// It only stays correct while all changes to this state go through it; code
+// that binds behind its back must call invalidate() afterwards. Textures and
+// VAOs are deleted only at exit, and a program deleted by a hot reload while
+// current stays alive until unbound, so a recycled name never looks bound.
+class RenderState
+{
+public:
+	static const int TEXTURE_UNITS = 4;
+
+	// The state of the (single) GL context of this process
+	static RenderState& current()
+	{
+		static RenderState s;
+		return s;
+	}
+
+	void useProgram(GLuint id)
+	{
+		if (!changed(program, id)) return;
+		glUseProgram(id);
+	}
+
+	void useProgram(const ShaderProgram& p) { useProgram(p.id); }
+
+	void bindVertexArray(GLuint id)
+	{
+		if (!changed(vertexArray, id)) return;
+		glBindVertexArray(id);
+	}
+
+	// Binds a 2D texture to `unit` for sampling. The active unit is only
+	// switched when a bind is actually needed.
+	void bindTexture(int unit, GLuint id)
+	{
+		if (!changed(textures[unit], id)) return;
+		if (changed(activeUnit, (GLuint)unit)) glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, id);
+	}
+
+	// Binds `id` on unit 0 and makes that unit active, for the glTex* calls
+	// that follow (they act on the active unit)
+	void bindTextureForUpload(GLuint id)
+	{
+		if (changed(activeUnit, 0)) glActiveTexture(GL_TEXTURE0);
+		bindTexture(0, id);
+	}
+
+	void depthMask(bool write)
+	{
+		if (!changed(depthWrite, write ? 1u : 0u)) return;
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+
+	void depthTest(bool on) { toggle(GL_DEPTH_TEST, depthTestOn, on); }
+	void cullFace(bool on) { toggle(GL_CULL_FACE, cullFaceOn, on); }
+	void blend(bool on) { toggle(GL_BLEND, blendOn, on); }
+
+	void blendFunc(GLenum src, GLenum dst)
+	{
+		if (blendSrc == src && blendDst == dst) {
+			ShaderProgram::stats().stateSkipped++;
+			return;
+		}
+		blendSrc = src;
+		blendDst = dst;
+		glBlendFunc(src, dst);
+		ShaderProgram::stats().stateCalls++;
+	}
+
+	// Forget everything: the next call of each setter is issued
+	void invalidate() { *this = RenderState(); }
+
+private:
+	static const GLuint UNKNOWN = 0xFFFFFFFFu;
+
+	GLuint program = UNKNOWN;
+	GLuint vertexArray = UNKNOWN;
+	GLuint textures[TEXTURE_UNITS] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+	GLuint activeUnit = UNKNOWN;
+	GLuint depthWrite = UNKNOWN;
+	GLuint depthTestOn = UNKNOWN, cullFaceOn = UNKNOWN, blendOn = UNKNOWN;
+	GLenum blendSrc = UNKNOWN, blendDst = UNKNOWN;
+
+	// Records `value` and returns true when it differs from the shadow copy
+	static bool changed(GLuint& shadow, GLuint value)
+	{
+		if (shadow == value) {
+			ShaderProgram::stats().stateSkipped++;
+			return false;
+		}
+		shadow = value;
+		ShaderProgram::stats().stateCalls++;
+		return true;
+	}
+
+	void toggle(GLenum cap, GLuint& shadow, bool on)
+	{
+		if (!changed(shadow, on ? 1u : 0u)) return;
+		if (on) glEnable(cap);
+		else glDisable(cap);
+	}
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <glad/glad.h>
+
+using namespace std;
+
+// GL calls issued through ShaderProgram, reset once per frame
+struct GLCallStats
+{
+	int uniformUploads = 0;  // glUniform* actually issued
+	int uniformsSkipped = 0; // setter calls filtered because the value was unchanged
+	int locationQueries = 0; // glGetUniformLocation / glGetActiveUniform
+	int stateCalls = 0;      // binds / enables issued through RenderState
+	int stateSkipped = 0;    // RenderState calls filtered as no-ops
+
+	void reset() { *this = GLCallStats(); }
+};
+
+// Linked program plus a table of its active uniforms. The table is filled
+// once by reflect() after linking, so the render loop never asks the driver
+// for locations by name. Setters take a UniformId resolved once by
+// uniform(name), so they do not hash names either. They remember the last
+// value uploaded and skip the glUniform* call when it has not changed; they
+// assume the program is currently bound with glUseProgram.
+class ShaderProgram
+{
+public:
+	struct Uniform
+	{
+		GLint location = -1;           // -1 = not active in this program
+		GLenum type = 0;
+		GLint size = 0;                // array length (1 for non-arrays)
+		vector<unsigned char> value;   // last uploaded bytes, empty = never set
+	};
+
+	// Index of a uniform name in every program's table. Names map to the
+	// same id in all programs, and ids stay valid when a program is
+	// relinked, so callers can look them up once and keep them.
+	typedef int UniformId;
+
+	unsigned int id = 0;
+
+	ShaderProgram() {}
+	explicit ShaderProgram(unsigned int program) { reset(program); }
+
+	static GLCallStats& stats()
+	{
+		static GLCallStats s;
+		return s;
+	}
+
+	// Adopt a (new) program and rebuild the uniform table
+	void reset(unsigned int program)
+	{
+		id = program;
+		uniforms.clear();
+		if (id != 0) {
+			reflect();
+		}
+	}
+
+	// Id of a uniform name (registers it on first use). Not for the render
+	// loop: keep the result, e.g. in a function-local static.
+	static UniformId uniform(const string& name)
+	{
+		unordered_map<string, UniformId>& ids = uniformIds();
+		auto it = ids.find(name);
+		if (it != ids.end()) return it->second;
+		UniformId uid = (UniformId)ids.size();
+		ids.emplace(name, uid);
+		return uid;
+	}
+
+	bool has(const string& name) const { return location(name) >= 0; }
+
+	GLint location(const string& name) const
+	{
+		auto it = uniformIds().find(name);
+		if (it == uniformIds().end() || (size_t)it->second >= uniforms.size()) return -1;
+		return uniforms[it->second].location;
+	}
+
+	void setInt(UniformId u, int v) { upload(u, &v, sizeof(v), 1); }
+	void setFloat(UniformId u, float v) { upload(u, &v, sizeof(v), 1); }
+	void setIntArray(UniformId u, const int* v, int count) { upload(u, v, count * sizeof(int), count); }
+	void setVec3(UniformId u, const float* v) { upload(u, v, 3 * sizeof(float), 1); }
+	void setMat3(UniformId u, const float* m) { upload(u, m, 9 * sizeof(float), 1); }
+	void setMat4(UniformId u, const float* m) { upload(u, m, 16 * sizeof(float), 1); }
+
+	// Attach a named uniform block to a buffer binding point (GLSL 330 has
+	// no layout(binding = N) for blocks). Inactive blocks are ignored.
+	void bindUniformBlock(const string& name, GLuint binding)
+	{
+		GLuint index = glGetUniformBlockIndex(id, name.c_str());
+		if (index != GL_INVALID_INDEX) {
+			glUniformBlockBinding(id, index, binding);
+		}
+	}
+
+	// Forget cached values (e.g. after something else wrote the uniforms)
+	void invalidate()
+	{
+		for (Uniform& u : uniforms) u.value.clear();
+	}
+
+private:
+	vector<Uniform> uniforms; // indexed by UniformId
+
+	static unordered_map<string, UniformId>& uniformIds()
+	{
+		static unordered_map<string, UniformId> ids;
+		return ids;
+	}
+
+	void reflect()
+	{
+		GLint count = 0, maxLength = 0;
+		glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		vector<char> nameBuf(maxLength > 0 ? maxLength : 1);
+
+		for (GLint i = 0; i < count; i++) {
+			Uniform u;
+			GLsizei length = 0;
+			glGetActiveUniform(id, (GLuint)i, (GLsizei)nameBuf.size(), &length, &u.size, &u.type, nameBuf.data());
+			string name(nameBuf.data(), length);
+			// Arrays are reported as "name[0]"
+			size_t bracket = name.find('[');
+			if (bracket != string::npos) name.erase(bracket);
+
+			u.location = glGetUniformLocation(id, name.c_str());
+			stats().locationQueries += 2;
+			if (u.location < 0) continue; // uniform block members
+			UniformId uid = uniform(name);
+			if ((size_t)uid >= uniforms.size()) uniforms.resize(uid + 1);
+			uniforms[uid] = u;
+		}
+	}
+
+	void upload(UniformId uid, const void* data, size_t bytes, int count)
+	{
+		if (uid < 0 || (size_t)uid >= uniforms.size()) return;
+		Uniform& u = uniforms[uid];
+		if (u.location < 0) return; // inactive / optimized out
+
+		if (u.value.size() == bytes && memcmp(u.value.data(), data, bytes) == 0) {
+			stats().uniformsSkipped++;
+			return;
+		}
+		u.value.assign((const unsigned char*)data, (const unsigned char*)data + bytes);
+		stats().uniformUploads++;
+
+		switch (u.type) {
+			case GL_FLOAT: glUniform1fv(u.location, count, (const GLfloat*)data); break;
+			case GL_FLOAT_VEC3: glUniform3fv(u.location, count, (const GLfloat*)data); break;
+			case GL_FLOAT_MAT3: glUniformMatrix3fv(u.location, count, GL_FALSE, (const GLfloat*)data); break;
+			case GL_FLOAT_MAT4: glUniformMatrix4fv(u.location, count, GL_FALSE, (const GLfloat*)data); break;
+			default: glUniform1iv(u.location, count, (const GLint*)data); break; // int, bool, samplers
+		}
+	}
+};
@@ -0,0 +1,96 @@
+#pragma once
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "MeshCache.h"
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+using namespace std;
+
+// Reports which files of a directory were saved since the last poll().
+// Uses inotify on Linux (a non-blocking read, no threads); other platforms
+// compare mtimes at most every 250 ms. Both a plain write and the
+// write-temp-then-rename most editors do count as one change.
+class ShaderWatcher
+{
+public:
+	~ShaderWatcher() { stop(); }
+
+	// Starts watching `files` (names relative to `directory`, which ends
+	// with a separator). Other files in the directory are ignored.
+	bool start(const string& directory, const vector<string>& files)
+	{
+		stop();
+		dir = directory;
+		for (const string& name : files) {
+			uint64_t size = 0; int64_t mtime = 0;
+			statFile(dir + name, size, mtime);
+			mtimes[name] = mtime;
+		}
+#ifdef __linux__
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0) return false;
+		if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+			close(fd);
+			fd = -1;
+			return false;
+		}
+#endif
+		lastScan = chrono::steady_clock::now();
+		return true;
+	}
+
+	void stop()
+	{
+#ifdef __linux__
+		if (fd >= 0) close(fd);
+		fd = -1;
+#endif
+		mtimes.clear();
+	}
+
+	// Watched files changed since the last call, each listed once
+	vector<string> poll()
+	{
+		set<string> changed;
+#ifdef __linux__
+		if (fd >= 0) {
+			alignas(inotify_event) char buffer[4096];
+			ssize_t length;
+			while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+				for (char* p = buffer; p < buffer + length; ) {
+					const inotify_event* e = (const inotify_event*)p;
+					if (e->len > 0 && mtimes.count(e->name)) changed.insert(e->name);
+					p += sizeof(inotify_event) + e->len;
+				}
+			}
+			return vector<string>(changed.begin(), changed.end());
+		}
+#endif
+		auto now = chrono::steady_clock::now();
+		if (now - lastScan < chrono::milliseconds(250)) return {};
+		lastScan = now;
+		for (auto& f : mtimes) {
+			uint64_t size = 0; int64_t mtime = 0;
+			if (statFile(dir + f.first, size, mtime) && mtime != f.second) {
+				f.second = mtime;
+				changed.insert(f.first);
+			}
+		}
+		return vector<string>(changed.begin(), changed.end());
+	}
+
+private:
+	string dir;
+	map<string, int64_t> mtimes; // watched names (mtime only used by the fallback)
+	chrono::steady_clock::time_point lastScan;
+#ifdef __linux__
+	int fd = -1;
+#endif
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <cmath>
+
+// Fixed-timestep simulation clock. Each frame, advance() returns how many
+// fixed steps to simulate; rendering then blends the last two simulated
+// states with alpha(), so animation speed no longer depends on frame rate.
+class SimClock
+{
+public:
+	// maxFrameSeconds caps the time simulated after a stall (e.g. a window
+	// drag) so a long hitch does not turn into hundreds of catch-up steps.
+	SimClock(double stepSeconds = 1.0 / 120.0, double maxFrameSeconds = 0.25)
+		: stepSize(stepSeconds), maxFrame(maxFrameSeconds) {}
+
+	int advance(double now)
+	{
+		if (lastTime < 0.0) {
+			lastTime = now;
+			return 0;
+		}
+		double frame = now - lastTime;
+		lastTime = now;
+		if (frame < 0.0) frame = 0.0;
+		if (frame > maxFrame) frame = maxFrame;
+
+		accumulator += frame;
+		int steps = (int)(accumulator / stepSize);
+		accumulator -= steps * stepSize;
+		return steps;
+	}
+
+	// Forgets the time since the last advance(), e.g. after the render loop
+	// sat idle, so the gap is not simulated as one long catch-up frame.
+	void skipTo(double now)
+	{
+		if (lastTime >= 0.0) lastTime = now;
+	}
+
+	float dt() const { return (float)stepSize; }
+
+	// Fraction of a step left in the accumulator, in [0, 1)
+	float alpha() const { return (float)(accumulator / stepSize); }
+
+private:
+	double stepSize;
+	double maxFrame;
+	double lastTime = -1.0;
+	double accumulator = 0.0;
+};
+
+// Frame-rate independent form of `x = mix(x, target, k)`: the remaining
+// distance shrinks by a factor e every `tau` seconds.
+inline float dampFactor(float tau, float dt)
+{
+	return 1.0f - expf(-dt / tau);
+}
@@ -0,0 +1,294 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <fstream>
+#include <algorithm>
+#include <glad/glad.h>
+#include "MeshCache.h"
+#include "TextureUploader.h"
+
+using namespace std;
+
+// S3TC block compression (BC1 for RGB, BC3 for RGBA) and the compressed
+// texture cache written next to an image (<image>.texcache).
+//
+// Cache layout: TextureCacheHeader, then per level a TextureCacheLevel
+// followed by its block data. Validated against the source image like the
+// mesh cache (size + mtime, content hash when only the mtime moved).
+static const char TEXTURE_CACHE_MAGIC[8] = { 'H', 'A', 'N', 'D', 'T', 'E', 'X', '\0' };
+static const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+struct TextureCacheHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t internalFormat; // GL_COMPRESSED_*_S3TC_*
+	uint64_t sourceSize;
+	int64_t sourceMtime;
+	uint64_t sourceHash;
+	uint32_t channels;
+	uint32_t levelCount;
+};
+
+struct TextureCacheLevel
+{
+	uint32_t width, height;
+	uint64_t size;
+};
+
+inline string textureCachePath(const string& imageFilename)
+{
+	return imageFilename + ".texcache";
+}
+
+// Bytes of one 4x4 block
+inline int compressedBlockBytes(GLenum format)
+{
+	return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ? 8 : 16;
+}
+
+inline GLenum compressedFormatFor(int channels)
+{
+	return channels == 4 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+inline uint16_t packRGB565(const float c[3])
+{
+	int r = (int)lrintf(min(max(c[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+	int g = (int)lrintf(min(max(c[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+	int b = (int)lrintf(min(max(c[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void unpackRGB565(uint16_t v, int c[3])
+{
+	c[0] = ((v >> 11) & 31) * 255 / 31;
+	c[1] = ((v >> 5) & 63) * 255 / 63;
+	c[2] = (v & 31) * 255 / 31;
+}
+
+// BC1 color block (always the 4-color mode, as BC3 requires). Endpoints
+// are the extremes of the block along its principal axis, pulled in a
+// little to spread the rounding error.
+inline void encodeColorBlock(const unsigned char rgba[16][4], unsigned char out[8])
+{
+	float mean[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		for (int k = 0; k < 3; k++) mean[k] += rgba[i][k] / 16.0f;
+	}
+	float cov[6] = { 0, 0, 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++) {
+		float d[3] = { rgba[i][0] - mean[0], rgba[i][1] - mean[1], rgba[i][2] - mean[2] };
+		cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+		cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+	}
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iter = 0; iter < 8; iter++) {
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float len = max(fabsf(x), max(fabsf(y), fabsf(z)));
+		if (len < 1e-6f) break;
+		axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+	}
+	float lo = 1e30f, hi = -1e30f;
+	for (int i = 0; i < 16; i++) {
+		float t = (rgba[i][0] - mean[0]) * axis[0] + (rgba[i][1] - mean[1]) * axis[1] + (rgba[i][2] - mean[2]) * axis[2];
+		lo = min(lo, t); hi = max(hi, t);
+	}
+	float axisLen2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float inset = (hi - lo) / 32.0f;
+	float e0[3], e1[3];
+	for (int k = 0; k < 3; k++) {
+		e0[k] = mean[k] + axis[k] * (hi - inset) / axisLen2;
+		e1[k] = mean[k] + axis[k] * (lo + inset) / axisLen2;
+	}
+	uint16_t c0 = packRGB565(e0), c1 = packRGB565(e1);
+	if (c0 < c1) swap(c0, c1);
+
+	uint32_t indices = 0;
+	if (c0 != c1) {
+		int p[4][3];
+		unpackRGB565(c0, p[0]);
+		unpackRGB565(c1, p[1]);
+		for (int k = 0; k < 3; k++) {
+			p[2][k] = (2 * p[0][k] + p[1][k]) / 3;
+			p[3][k] = (p[0][k] + 2 * p[1][k]) / 3;
+		}
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestErr = 1 << 30;
+			for (int j = 0; j < 4; j++) {
+				int dr = rgba[i][0] - p[j][0], dg = rgba[i][1] - p[j][1], db = rgba[i][2] - p[j][2];
+				int err = dr * dr + dg * dg + db * db;
+				if (err < bestErr) { bestErr = err; best = j; }
+			}
+			indices |= (uint32_t)best << (2 * i);
+		}
+	}
+	out[0] = (unsigned char)(c0 & 0xFF); out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xFF); out[3] = (unsigned char)(c1 >> 8);
+	for (int k = 0; k < 4; k++) out[4 + k] = (unsigned char)(indices >> (8 * k));
+}
+
+// BC3 alpha block, 8-value mode between the block's min and max alpha
+inline void encodeAlphaBlock(const unsigned char rgba[16][4], unsigned char out[8])
+{
+	int a0 = 0, a1 = 255;
+	for (int i = 0; i < 16; i++) {
+		a0 = max(a0, (int)rgba[i][3]);
+		a1 = min(a1, (int)rgba[i][3]);
+	}
+	uint64_t indices = 0;
+	if (a0 != a1) {
+		int palette[8] = { a0, a1 };
+		for (int j = 1; j < 7; j++) palette[j + 1] = ((7 - j) * a0 + j * a1) / 7;
+		for (int i = 0; i < 16; i++) {
+			int best = 0, bestErr = 1 << 30;
+			for (int j = 0; j < 8; j++) {
+				int err = abs(rgba[i][3] - palette[j]);
+				if (err < bestErr) { bestErr = err; best = j; }
+			}
+			indices |= (uint64_t)best << (3 * i);
+		}
+	}
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	for (int k = 0; k < 6; k++) out[2 + k] = (unsigned char)(indices >> (8 * k));
+}
+
+// Compresses every level of `image` (RGB or RGBA, usually after
+// buildMipChain). Edge blocks repeat the last row/column.
+inline DecodedImage compressImage(const DecodedImage& image)
+{
+	DecodedImage result;
+	result.channels = image.channels;
+	result.compressedFormat = compressedFormatFor(image.channels);
+	const int blockBytes = compressedBlockBytes(result.compressedFormat);
+	const int c = image.channels;
+
+	for (const MipLevel& level : image.levels) {
+		MipLevel out;
+		out.width = level.width;
+		out.height = level.height;
+		int bw = (level.width + 3) / 4, bh = (level.height + 3) / 4;
+		out.pixels.resize((size_t)bw * bh * blockBytes);
+		for (int by = 0; by < bh; by++) {
+			for (int bx = 0; bx < bw; bx++) {
+				unsigned char block[16][4];
+				for (int i = 0; i < 16; i++) {
+					int x = min(bx * 4 + (i & 3), level.width - 1);
+					int y = min(by * 4 + (i >> 2), level.height - 1);
+					const unsigned char* px = &level.pixels[((size_t)y * level.width + x) * c];
+					block[i][0] = px[0]; block[i][1] = px[1]; block[i][2] = px[2];
+					block[i][3] = c == 4 ? px[3] : 255;
+				}
+				unsigned char* dst = &out.pixels[((size_t)by * bw + bx) * blockBytes];
+				if (c == 4) {
+					encodeAlphaBlock(block, dst);
+					encodeColorBlock(block, dst + 8);
+				} else {
+					encodeColorBlock(block, dst);
+				}
+			}
+		}
+		result.levels.push_back(move(out));
+	}
+	return result;
+}
+
+// Loads the compressed levels cached for `imageFilename` if still current
+inline bool readTextureCache(const string& imageFilename, DecodedImage& out, bool& stale)
+{
+	stale = false;
+	uint64_t srcSize; int64_t srcMtime;
+	if (!statFile(imageFilename, srcSize, srcMtime)) return false;
+
+	MappedFile file(textureCachePath(imageFilename));
+	if (!file.valid() || file.size() < sizeof(TextureCacheHeader)) return false;
+
+	TextureCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic)) != 0) return false;
+	if (header.version != TEXTURE_CACHE_VERSION) return false;
+	if (header.channels != 3 && header.channels != 4) return false;
+	if (header.internalFormat != compressedFormatFor((int)header.channels)) return false;
+	if (header.sourceSize != srcSize) return false;
+	if (header.sourceMtime != srcMtime) {
+		if (hashFile(imageFilename) != header.sourceHash) return false;
+		stale = true;
+	}
+
+	DecodedImage image;
+	image.channels = (int)header.channels;
+	image.compressedFormat = header.internalFormat;
+	// Levels must form the chain compressImage writes: level l is level 0
+	// halved l times (at least 1x1), no more levels than down to 1x1, and
+	// each holds exactly its blocks. A size is bounded by the rest of the
+	// file before it is added to the offset, so it cannot wrap.
+	const uint64_t blockBytes = (uint64_t)compressedBlockBytes(image.compressedFormat);
+	uint32_t width0 = 0, height0 = 0;
+	size_t offset = sizeof(TextureCacheHeader);
+	for (uint32_t l = 0; l < header.levelCount; l++) {
+		TextureCacheLevel info;
+		if (sizeof(info) > file.size() - offset) return false;
+		memcpy(&info, file.data() + offset, sizeof(info));
+		offset += sizeof(info);
+		if (l == 0) {
+			if (info.width == 0 || info.height == 0 || info.width > INT_MAX || info.height > INT_MAX) return false;
+			width0 = info.width;
+			height0 = info.height;
+			uint32_t maxLevels = 1;
+			for (uint32_t d = max(width0, height0); d > 1; d >>= 1) maxLevels++;
+			if (header.levelCount > maxLevels) return false;
+		} else if (info.width != max(width0 >> l, 1u) || info.height != max(height0 >> l, 1u)) {
+			return false;
+		}
+		uint64_t blocks = (uint64_t)((info.width + 3) / 4) * ((info.height + 3) / 4);
+		if (info.size > file.size() - offset || info.size != blocks * blockBytes) return false;
+		MipLevel level;
+		level.width = (int)info.width;
+		level.height = (int)info.height;
+		level.pixels.assign(file.data() + offset, file.data() + offset + info.size);
+		offset += (size_t)info.size;
+		image.levels.push_back(move(level));
+	}
+	if (offset != file.size() || image.empty()) return false;
+	out = move(image);
+	return true;
+}
+
+// Temp file + rename, like the mesh cache
+inline bool writeTextureCache(const string& imageFilename, const DecodedImage& image)
+{
+	TextureCacheHeader header;
+	memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+	header.version = TEXTURE_CACHE_VERSION;
+	header.internalFormat = image.compressedFormat;
+	if (!statFile(imageFilename, header.sourceSize, header.sourceMtime)) return false;
+	header.sourceHash = hashFile(imageFilename);
+	header.channels = (uint32_t)image.channels;
+	header.levelCount = (uint32_t)image.levels.size();
+
+	string path = textureCachePath(imageFilename);
+	string tmpPath = path + ".tmp";
+	{
+		ofstream f(tmpPath, ios::binary | ios::trunc);
+		if (!f) return false;
+		f.write((const char*)&header, sizeof(header));
+		for (const MipLevel& level : image.levels) {
+			TextureCacheLevel info = { (uint32_t)level.width, (uint32_t)level.height, (uint64_t)level.pixels.size() };
+			f.write((const char*)&info, sizeof(info));
+			f.write((const char*)level.pixels.data(), level.pixels.size());
+		}
+		if (!f) { f.close(); remove(tmpPath.c_str()); return false; }
+	}
+#ifdef _WIN32
+	remove(path.c_str());
+#endif
+	return rename(tmpPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <glad/glad.h>
+#include "RenderState.h"
+
+using namespace std;
+
+// One mip level, tightly packed rows, bottom row first (GL order). For a
+// compressed image the rows are rows of 4x4 blocks.
+struct MipLevel
+{
+	int width = 0, height = 0;
+	vector<unsigned char> pixels;
+};
+
+// Decoded image, level 0 first. More than one level means the mip chain
+// was built on the CPU (buildMipChain) and is uploaded as is.
+struct DecodedImage
+{
+	int channels = 0;
+	GLenum compressedFormat = 0; // S3TC blocks instead of pixels (TextureCompress.h)
+	vector<MipLevel> levels;
+
+	bool empty() const { return levels.empty() || levels[0].pixels.empty(); }
+	int width() const { return levels.empty() ? 0 : levels[0].width; }
+	int height() const { return levels.empty() ? 0 : levels[0].height; }
+};
+
+// Appends levels 1..n down to 1x1 with a 2x2 box filter (edge texels are
+// repeated for odd sizes). Pure CPU work, safe on a worker thread.
+inline void buildMipChain(DecodedImage& image)
+{
+	if (image.empty()) return;
+	image.levels.resize(1);
+	const int c = image.channels;
+	while (image.levels.back().width > 1 || image.levels.back().height > 1) {
+		const MipLevel& src = image.levels.back();
+		MipLevel dst;
+		dst.width = max(src.width / 2, 1);
+		dst.height = max(src.height / 2, 1);
+		dst.pixels.resize((size_t)dst.width * dst.height * c);
+		for (int y = 0; y < dst.height; y++) {
+			const unsigned char* r0 = &src.pixels[(size_t)min(2 * y, src.height - 1) * src.width * c];
+			const unsigned char* r1 = &src.pixels[(size_t)min(2 * y + 1, src.height - 1) * src.width * c];
+			unsigned char* out = &dst.pixels[(size_t)y * dst.width * c];
+			for (int x = 0; x < dst.width; x++) {
+				int x0 = min(2 * x, src.width - 1) * c, x1 = min(2 * x + 1, src.width - 1) * c;
+				for (int k = 0; k < c; k++) {
+					out[x * c + k] = (unsigned char)((r0[x0 + k] + r0[x1 + k] + r1[x0 + k] + r1[x1 + k] + 2) >> 2);
+				}
+			}
+		}
+		image.levels.push_back(move(dst));
+	}
+}
+
+// Streams images into textures through a ring of pixel unpack buffers.
+// Each update() copies at most `budget` bytes into mapped PBOs and issues
+// glTexSubImage2D from them, so a large texture is spread over several
+// frames instead of stalling one. A slot is reused only after the fence
+// placed behind its last upload has signaled. A texture may be sampled
+// once isComplete() says so.
+class TextureUploader
+{
+public:
+	static const int RING_SIZE = 3;
+	size_t slotBytes = 4 << 20; // capacity of each PBO
+
+	void destroy()
+	{
+		for (Slot& s : slots) {
+			if (s.fence) glDeleteSync(s.fence);
+			if (s.buffer) glDeleteBuffers(1, &s.buffer);
+			s = Slot();
+		}
+		for (Job& j : jobs) glDeleteTextures(1, &j.texture);
+		jobs.clear();
+	}
+
+	// Creates the texture (storage only) and queues its pixels. Without a
+	// CPU mip chain the mipmaps are generated by GL after the last row.
+	unsigned int begin(DecodedImage&& image)
+	{
+		unsigned int texture;
+		glGenTextures(1, &texture);
+		RenderState::current().bindTextureForUpload(texture);
+		Job job;
+		job.texture = texture;
+		job.format = image.channels == 4 ? GL_RGBA : GL_RGB;
+		job.compressedFormat = image.compressedFormat;
+		job.generateMipmaps = image.levels.size() == 1 && job.compressedFormat == 0;
+		for (size_t l = 0; l < image.levels.size(); l++) {
+			const MipLevel& m = image.levels[l];
+			if (job.compressedFormat) {
+				glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)l, job.compressedFormat, m.width, m.height, 0, (GLsizei)m.pixels.size(), NULL);
+			} else {
+				glTexImage2D(GL_TEXTURE_2D, (GLint)l, job.format, m.width, m.height, 0, job.format, GL_UNSIGNED_BYTE, NULL);
+			}
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, job.generateMipmaps ? 1000 : (GLint)image.levels.size() - 1);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		job.levels = move(image.levels);
+		jobs.push_back(move(job));
+		return texture;
+	}
+
+	bool busy() const { return !jobs.empty(); }
+
+	bool isComplete(unsigned int texture) const
+	{
+		for (const Job& j : jobs) {
+			if (j.texture == texture) return false;
+		}
+		return texture != 0;
+	}
+
+	// Moves up to `budget` bytes. Returns early when the next slot is
+	// still being read by the GPU.
+	void update(size_t budget)
+	{
+		if (jobs.empty()) return;
+		if (slots[0].buffer == 0) createSlots();
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		size_t moved = 0;
+		while (!jobs.empty() && moved < budget) {
+			Slot& slot = slots[nextSlot];
+			if (slot.fence) {
+				GLenum state = glClientWaitSync(slot.fence, 0, 0);
+				if (state == GL_TIMEOUT_EXPIRED) break;
+				glDeleteSync(slot.fence);
+				slot.fence = 0;
+			}
+
+			Job& job = jobs.front();
+			const MipLevel& level = job.levels[job.level];
+			// Compressed levels go in rows of 4x4 blocks
+			int rowPixels = job.compressedFormat ? 4 : 1;
+			int levelRows = (level.height + rowPixels - 1) / rowPixels;
+			size_t rowBytes = level.pixels.size() / levelRows;
+			int rows = (int)max<size_t>(1, min(slotBytes, budget - moved) / rowBytes);
+			rows = min(rows, levelRows - job.row);
+			size_t bytes = rowBytes * rows;
+			const unsigned char* src = &level.pixels[(size_t)job.row * rowBytes];
+
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+			if (bytes > slot.capacity) {
+				glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+				slot.capacity = bytes;
+			}
+			void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+			if (dst) {
+				memcpy(dst, src, bytes);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+				src = NULL; // offset 0 in the bound PBO
+			} else {
+				// Mapping failed (out of memory): upload this chunk directly
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+			RenderState::current().bindTextureForUpload(job.texture);
+			int y = job.row * rowPixels;
+			int height = min(rows * rowPixels, level.height - y);
+			if (job.compressedFormat) {
+				glCompressedTexSubImage2D(GL_TEXTURE_2D, job.level, 0, y, level.width, height, job.compressedFormat, (GLsizei)bytes, src);
+			} else {
+				glTexSubImage2D(GL_TEXTURE_2D, job.level, 0, y, level.width, height, job.format, GL_UNSIGNED_BYTE, src);
+			}
+			slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			nextSlot = (nextSlot + 1) % RING_SIZE;
+			moved += bytes;
+
+			job.row += rows;
+			if (job.row == levelRows) {
+				job.row = 0;
+				job.level++;
+				if (job.level == (int)job.levels.size()) {
+					if (job.generateMipmaps) glGenerateMipmap(GL_TEXTURE_2D);
+					jobs.pop_front();
+				}
+			}
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	// Uploads everything that is queued, waiting for the GPU as needed
+	void finish()
+	{
+		while (busy()) {
+			update(SIZE_MAX);
+			Slot& slot = slots[nextSlot];
+			if (busy() && slot.fence) glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		GLuint buffer = 0;
+		size_t capacity = 0;
+		GLsync fence = 0;
+	};
+	struct Job
+	{
+		unsigned int texture = 0;
+		GLenum format = GL_RGBA;
+		GLenum compressedFormat = 0;
+		bool generateMipmaps = false;
+		vector<MipLevel> levels;
+		int level = 0, row = 0; // next row (of pixels or blocks) to upload
+	};
+
+	Slot slots[RING_SIZE];
+	int nextSlot = 0;
+	deque<Job> jobs;
+
+	void createSlots()
+	{
+		for (Slot& s : slots) {
+			glGenBuffers(1, &s.buffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s.buffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, slotBytes, NULL, GL_STREAM_DRAW);
+			s.capacity = slotBytes;
+		}
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <glad/glad.h>
+
+using namespace std;
+
+// Which of Object's arrays an attribute is read from
+enum class ATTRIBSOURCE
+{
+	POSITION,
+	NORMAL,
+	TEXCOORD,
+	TAG // Object::tags, one integer per vertex
+};
+
+// Storage format of one attribute inside the interleaved vertex
+enum class ATTRIBFORMAT
+{
+	FLOAT3,         // 12 bytes
+	FLOAT2,         // 8 bytes
+	INT_2_10_10_10, // 4 bytes, signed normalized xyz (w unused)
+	HALF2,          // 4 bytes
+	USHORT2_NORM,   // 4 bytes, unsigned normalized, only valid for [0, 1]
+	UBYTE_INT       // 4 bytes, one unsigned byte read as an integer (uint/int in GLSL), padded for alignment
+};
+
+struct VertexAttrib
+{
+	unsigned int location;
+	ATTRIBSOURCE source;
+	ATTRIBFORMAT format;
+	unsigned int offset;
+};
+
+// Describes an interleaved vertex: attributes are packed back to back in
+// the order they were added, and apply() replaces hard-coded
+// glVertexAttribPointer calls for the currently bound VAO/VBO.
+struct VertexLayout
+{
+	vector<VertexAttrib> attribs;
+	unsigned int stride = 0;
+
+	static unsigned int formatSize(ATTRIBFORMAT format)
+	{
+		switch (format) {
+			case ATTRIBFORMAT::FLOAT3: return 12;
+			case ATTRIBFORMAT::FLOAT2: return 8;
+			default: return 4;
+		}
+	}
+
+	VertexLayout& add(unsigned int location, ATTRIBSOURCE source, ATTRIBFORMAT format)
+	{
+		attribs.push_back({ location, source, format, stride });
+		stride += formatSize(format);
+		return *this;
+	}
+
+	void apply() const
+	{
+		for (const auto& a : attribs) {
+			if (a.format == ATTRIBFORMAT::UBYTE_INT) {
+				glVertexAttribIPointer(a.location, 1, GL_UNSIGNED_BYTE, stride, (void*)(uintptr_t)a.offset);
+				glEnableVertexAttribArray(a.location);
+				continue;
+			}
+			GLint size = 2; GLenum type = GL_FLOAT; GLboolean normalized = GL_FALSE;
+			switch (a.format) {
+				case ATTRIBFORMAT::FLOAT3: size = 3; type = GL_FLOAT; break;
+				case ATTRIBFORMAT::FLOAT2: size = 2; type = GL_FLOAT; break;
+				case ATTRIBFORMAT::INT_2_10_10_10: size = 4; type = GL_INT_2_10_10_10_REV; normalized = GL_TRUE; break;
+				case ATTRIBFORMAT::HALF2: size = 2; type = GL_HALF_FLOAT; break;
+				case ATTRIBFORMAT::USHORT2_NORM: size = 2; type = GL_UNSIGNED_SHORT; normalized = GL_TRUE; break;
+				case ATTRIBFORMAT::UBYTE_INT: break;
+			}
+			glVertexAttribPointer(a.location, size, type, normalized, stride, (void*)(uintptr_t)a.offset);
+			glEnableVertexAttribArray(a.location);
+		}
+	}
+};
+
+// ---- packing helpers (CPU side mirror of what the GL unpacks) ----
+
+// Signed normalized 10-bit, GL 4.2+/ES3 rule: value = max(c / 511, -1).
+// Older GL 3.3 drivers use (2c + 1) / 1023 instead, off by at most 1/1023.
+inline uint32_t packSnorm10(float v)
+{
+	v = fminf(fmaxf(v, -1.0f), 1.0f);
+	int32_t q = (int32_t)lroundf(v * 511.0f);
+	return (uint32_t)q & 0x3FFu;
+}
+
+inline float unpackSnorm10(uint32_t bits)
+{
+	int32_t q = (int32_t)(bits << 22) >> 22; // sign extend
+	return fmaxf((float)q / 511.0f, -1.0f);
+}
+
+inline uint32_t packNormal2_10_10_10(float x, float y, float z)
+{
+	return packSnorm10(x) | (packSnorm10(y) << 10) | (packSnorm10(z) << 20);
+}
+
+inline uint16_t packUnorm16(float v)
+{
+	v = fminf(fmaxf(v, 0.0f), 1.0f);
+	return (uint16_t)lroundf(v * 65535.0f);
+}
+
+inline float unpackUnorm16(uint16_t bits)
+{
+	return (float)bits / 65535.0f;
+}
+
+// IEEE 754 binary16 with round-to-nearest-even; overflow goes to infinity
+inline uint16_t floatToHalf(float f)
+{
+	uint32_t x; memcpy(&x, &f, 4);
+	uint32_t sign = (x >> 16) & 0x8000u;
+	uint32_t mag = x & 0x7FFFFFFFu;
+
+	if (mag >= 0x7F800000u) { // Inf / NaN
+		return (uint16_t)(sign | 0x7C00u | (mag > 0x7F800000u ? 0x200u : 0u));
+	}
+	if (mag >= 0x477FF000u) { // rounds past the largest half
+		return (uint16_t)(sign | 0x7C00u);
+	}
+	if (mag < 0x38800000u) { // subnormal half (or zero)
+		if (mag < 0x33000000u) return (uint16_t)sign;
+		uint32_t e = mag >> 23;
+		uint32_t m = (mag & 0x7FFFFFu) | 0x800000u;
+		uint32_t shift = 126 - e; // 14..24
+		uint32_t half = m >> shift;
+		uint32_t rem = m & ((1u << shift) - 1u);
+		uint32_t mid = 1u << (shift - 1);
+		if (rem > mid || (rem == mid && (half & 1u))) half++;
+		return (uint16_t)(sign | half);
+	}
+	uint32_t half = ((mag - 0x38000000u) >> 13);
+	uint32_t rem = mag & 0x1FFFu;
+	if (rem > 0x1000u || (rem == 0x1000u && (half & 1u))) half++;
+	return (uint16_t)(sign | half);
+}
+
+inline float halfToFloat(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000u) << 16;
+	uint32_t e = (h >> 10) & 0x1Fu;
+	uint32_t m = h & 0x3FFu;
+	uint32_t x;
+	if (e == 0) {
+		if (m == 0) {
+			x = sign;
+		} else { // normalize subnormal
+			e = 113;
+			while ((m & 0x400u) == 0) { m <<= 1; e--; }
+			x = sign | (e << 23) | ((m & 0x3FFu) << 13);
+		}
+	} else if (e == 31) {
+		x = sign | 0x7F800000u | (m << 13);
+	} else {
+		x = sign | ((e + 112) << 23) | (m << 13);
+	}
+	float f; memcpy(&f, &x, 4);
+	return f;
+}
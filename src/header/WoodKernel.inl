@@ -0,0 +1,229 @@
+// Wood grain kernel shared by the CPU generator's SIMD levels. This file is
+// included once per level, inside its own namespace, after that level has
+// defined:
+//   struct VF       one vector of VWIDTH floats, with + - * / and a
+//                   converting constructor from float
+//   VWIDTH          lanes per VF
+//   vload/vstore    unaligned load/store of VWIDTH floats
+//   vfloor, vmin, vmax
+//   vgt(a, b)       lane mask a > b; vselect(mask, a, b) picks a where set
+//   vreduce(x, r, q)  x = r + q * pi/2 with |r| <= pi/4, q in {0,1,2,3};
+//                   done in double so large hash arguments stay exact
+//   vmantissa(x, e) returns m in [1, 2) with x = m * 2^e
+//   vpow2i(n)       2^n for integral n
+// Everything below mirrors backgroundShader.frag line by line; keep the
+// two in sync.
+
+// Cephes sinf/cosf polynomials on [-pi/4, pi/4]
+inline VF woodSinPoly(VF x)
+{
+	VF z = x * x;
+	return ((VF(-1.9515295891e-4f) * z + VF(8.3321608736e-3f)) * z - VF(1.6666654611e-1f)) * z * x + x;
+}
+
+inline VF woodCosPoly(VF x)
+{
+	VF z = x * x;
+	return ((VF(2.443315711809948e-5f) * z - VF(1.388731625493765e-3f)) * z + VF(4.166664568298827e-2f)) * z * z
+		- VF(0.5f) * z + VF(1.0f);
+}
+
+// Quadrant q of the reduced argument: 0 sin, 1 cos, 2 -sin, 3 -cos
+inline VF woodQuadrant(VF r, VF q)
+{
+	VF odd = q - VF(2.0f) * vfloor(q * VF(0.5f));
+	VF v = vselect(vgt(odd, VF(0.5f)), woodCosPoly(r), woodSinPoly(r));
+	return vselect(vgt(q, VF(1.5f)), VF(0.0f) - v, v);
+}
+
+inline VF woodSin(VF x)
+{
+	VF r, q;
+	vreduce(x, r, q);
+	return woodQuadrant(r, q);
+}
+
+inline VF woodCos(VF x)
+{
+	VF r, q;
+	vreduce(x, r, q);
+	q = q + VF(1.0f);
+	q = q - VF(4.0f) * vfloor(q * VF(0.25f));
+	return woodQuadrant(r, q);
+}
+
+inline VF woodFract(VF x)
+{
+	return x - vfloor(x);
+}
+
+// log2 via atanh series on the mantissa, exp2 via a Taylor polynomial;
+// about 1e-6 relative, far below one 8-bit step
+inline VF woodPow(VF x, float exponent)
+{
+	VF e;
+	VF m = vmantissa(vmax(x, VF(1e-30f)), e);
+	VF t = (m - VF(1.0f)) / (m + VF(1.0f));
+	VF t2 = t * t;
+	VF series = t * (VF(1.0f) + t2 * (VF(1.0f / 3.0f) + t2 * (VF(1.0f / 5.0f) + t2 * (VF(1.0f / 7.0f) + t2 * VF(1.0f / 9.0f)))));
+	VF log2x = e + series * VF(2.88539008177792681f); // 2 / ln 2
+
+	VF y = log2x * VF(exponent);
+	VF n = vfloor(y);
+	VF f = (y - n) * VF(0.69314718055994531f);
+	VF p = VF(1.0f) + f * (VF(1.0f) + f * (VF(1.0f / 2.0f) + f * (VF(1.0f / 6.0f) + f * (VF(1.0f / 24.0f)
+		+ f * (VF(1.0f / 120.0f) + f * (VF(1.0f / 720.0f) + f * VF(1.0f / 5040.0f)))))));
+	VF result = p * vpow2i(vmax(n, VF(-126.0f)));
+	return vselect(vgt(x, VF(0.0f)), result, VF(0.0f));
+}
+
+inline VF woodNoise(VF px, VF py)
+{
+	return woodFract(woodSin(px * VF(127.1f) + py * VF(311.7f)) * VF(43758.5453f));
+}
+
+inline VF woodMix(VF a, VF b, VF t)
+{
+	return a * (VF(1.0f) - t) + b * t;
+}
+
+inline VF woodSmoothNoise(VF px, VF py)
+{
+	VF ix = vfloor(px), iy = vfloor(py);
+	VF fx = px - ix, fy = py - iy;
+	fx = fx * fx * (VF(3.0f) - VF(2.0f) * fx);
+	fy = fy * fy * (VF(3.0f) - VF(2.0f) * fy);
+
+	VF a = woodNoise(ix, iy);
+	VF b = woodNoise(ix + VF(1.0f), iy);
+	VF c = woodNoise(ix, iy + VF(1.0f));
+	VF d = woodNoise(ix + VF(1.0f), iy + VF(1.0f));
+	return woodMix(woodMix(a, b, fx), woodMix(c, d, fx), fy);
+}
+
+// smoothNoiseAA with its sample count already known: p is linear in the
+// pixel position, so dFdx/dFdy (and the count) are the same for all pixels
+inline VF woodSmoothNoiseAA(VF px, VF py, int numSamples)
+{
+	if (numSamples == 0) {
+		return woodSmoothNoise(px, py);
+	}
+	VF result(0.0f);
+	float offset = 0.25f;
+	for (int i = 0; i < numSamples; i++) {
+		for (int j = 0; j < numSamples; j++) {
+			result = result + woodSmoothNoise(px + VF((float)i * offset / (float)numSamples),
+				py + VF((float)j * offset / (float)numSamples));
+		}
+	}
+	return result / VF((float)(numSamples * numSamples));
+}
+
+// 0 = no anti-aliasing, else the loop size smoothNoiseAA would pick for
+// p = (TexCoord * 8) * (sx, sy) on a width x height framebuffer
+inline int woodSampleCount(float sx, float sy, int width, int height)
+{
+	float samples = fmaxf(8.0f * sx / (float)width, 8.0f * sy / (float)height);
+	if (samples < 1.0f) return 0;
+	return min((int)(samples * 2.0f), 4);
+}
+
+// Renders pixels [x0, x1) x [y0, y1) (GL coordinates, y up) of the
+// background into `rgba` (width x height, bottom row first). x0 and y0
+// must be even: fwidth() is taken inside 2x2 pixel quads like on the GPU.
+inline void woodBakeTile(int width, int height, int x0, int y0, int x1, int y1, unsigned char* rgba)
+{
+	const int n0 = woodSampleCount(0.15f, 4.0f, width, height);
+	const int n1 = woodSampleCount(0.3f, 8.0f, width, height);
+	const int n2 = woodSampleCount(0.6f, 16.0f, width, height);
+	const int nd = woodSampleCount(30.0f, 30.0f, width, height);
+
+	// Quads are complete even past the image edge; rows padded to VWIDTH
+	int cols = (x1 - x0 + 1) & ~1;
+	int rows = (y1 - y0 + 1) & ~1;
+	int stride = (cols + VWIDTH - 1) / VWIDTH * VWIDTH;
+	vector<float> pattern((size_t)stride * rows);
+	vector<float> ringWidth(stride);
+	float lanes[16];
+	for (int i = 0; i < 16; i++) lanes[i] = (float)i;
+	VF laneOffset = vload(lanes);
+
+	auto texU = [width](VF x) { return (x + VF(0.5f)) / VF((float)width); };
+	auto texV = [height](float y) { return (y + 0.5f) / (float)height; };
+
+	// Pass 1: wood pattern (three octaves) for every pixel of the quads
+	for (int row = 0; row < rows; row++) {
+		VF v = VF(texV((float)(y0 + row)) * 8.0f);
+		for (int col = 0; col < stride; col += VWIDTH) {
+			VF u = texU(VF((float)(x0 + col)) + laneOffset) * VF(8.0f);
+			VF wood = woodSmoothNoiseAA(u * VF(0.15f), v * VF(4.0f), n0);
+			wood = wood + woodSmoothNoiseAA(u * VF(0.3f), v * VF(8.0f), n1) * VF(0.6f);
+			wood = wood + woodSmoothNoiseAA(u * VF(0.6f), v * VF(16.0f), n2) * VF(0.3f);
+			wood = wood / VF(1.9f);
+			vstore(&pattern[(size_t)row * stride + col], wood);
+		}
+	}
+
+	const float darkWood[3] = { 0.25f, 0.18f, 0.14f };
+	const float midWood[3] = { 0.38f, 0.28f, 0.22f };
+	const float lightWood[3] = { 0.48f, 0.36f, 0.28f };
+	float channel[3][16];
+
+	// Pass 2: rings, colors and detail, one output row at a time
+	for (int row = 0; row < y1 - y0; row++) {
+		int quadRow = row & ~1;
+		float vq0 = texV((float)(y0 + quadRow)) * 8.0f;
+		float vq1 = texV((float)(y0 + quadRow + 1)) * 8.0f;
+		const float* p0 = &pattern[(size_t)quadRow * stride];
+		const float* p1 = p0 + stride;
+		for (int col = 0; col < cols; col++) {
+			// fwidth(ringFreq) = |dFdx| + |dFdy| inside the quad
+			int qc = col & ~1;
+			const float* pr = (row & 1) ? p1 : p0;
+			float vr = (row & 1) ? vq1 : vq0;
+			float dx = (vr * 10.0f + pr[qc + 1] * 3.0f) - (vr * 10.0f + pr[qc] * 3.0f);
+			float dy = (vq1 * 10.0f + p1[col] * 3.0f) - (vq0 * 10.0f + p0[col] * 3.0f);
+			ringWidth[col] = fabsf(dx) + fabsf(dy);
+		}
+
+		float texY = texV((float)(y0 + row));
+		VF v = VF(texY * 8.0f);
+		VF vignette = VF(1.0f - (texY - 0.5f) * 0.12f);
+		const float* pr = &pattern[(size_t)row * stride];
+		unsigned char* out = rgba + ((size_t)(y0 + row) * width + x0) * 4;
+
+		for (int col = 0; col < x1 - x0; col += VWIDTH) {
+			VF u = texU(VF((float)(x0 + col)) + laneOffset) * VF(8.0f);
+			VF wood = vload(pr + col);
+
+			VF ringFreq = v * VF(10.0f) + wood * VF(3.0f);
+			VF gradient = vload(&ringWidth[col]) * VF(2.0f);
+			VF sinR = woodSin(ringFreq);
+			VF filtered = (sinR + gradient * woodCos(ringFreq)) / (VF(1.0f) + gradient);
+			filtered = filtered * VF(0.5f) + VF(0.5f);
+			VF t = vmin(vmax((filtered - VF(0.2f)) / VF(0.6f), VF(0.0f)), VF(1.0f));
+			filtered = t * t * (VF(3.0f) - VF(2.0f) * t);
+			VF rings = vselect(vgt(gradient, VF(0.01f)), filtered, sinR * VF(0.5f) + VF(0.5f));
+			rings = woodPow(rings, 0.7f);
+
+			VF detail = woodSmoothNoiseAA(u * VF(30.0f), v * VF(30.0f), nd) * VF(0.04f);
+			for (int c = 0; c < 3; c++) {
+				VF color = woodMix(VF(darkWood[c]), VF(midWood[c]), wood);
+				color = woodMix(color, VF(lightWood[c]), rings * VF(0.4f));
+				color = color + detail;
+				color = color * vignette;
+				vstore(channel[c], color);
+			}
+
+			int count = min(VWIDTH, x1 - x0 - col);
+			for (int i = 0; i < count; i++) {
+				unsigned char* px = out + (size_t)(col + i) * 4;
+				for (int c = 0; c < 3; c++) {
+					float f = fminf(fmaxf(channel[c][i], 0.0f), 1.0f);
+					px[c] = (unsigned char)lrintf(f * 255.0f);
+				}
+				px[3] = 255;
+			}
+		}
+	}
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+using namespace std;
+
+// Instruction sets the CPU wood generator can run on
+enum class WOODSIMD
+{
+	AUTO,   // best one the build and the CPU support
+	SCALAR, // one pixel at a time (reference)
+	SSE2,   // 4 pixels per vector
+	AVX2    // 8 pixels per vector
+};
+
+const char* woodSimdName(WOODSIMD simd);
+
+// Resolves AUTO and falls back when a level is not built in or not
+// supported by this CPU
+WOODSIMD resolveWoodSimd(WOODSIMD simd);
+
+// CPU port of backgroundShader.frag. Bakes the wood background as it would
+// be rendered into a width x height framebuffer: tightly packed RGBA8, GL
+// row order (bottom row first), so it can go straight into a texture.
+// Work is split into 64x64 tiles shared by `threads` workers (0 = all
+// cores). All SIMD levels give the same result up to rounding (a few 1/255
+// steps at most); the GPU differs a little more where its sin() is less
+// exact.
+void bakeWoodTexture(int width, int height, vector<unsigned char>& rgba, int threads = 0, WOODSIMD simd = WOODSIMD::AUTO);
@@ -7,36 +7,125 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
 
 #include "./header/Object.h"
+#include "./header/HandRegions.h"
+#include "./header/Decorations.h"
+#include "./header/Shader.h"
+#include "./header/RenderState.h"
+#include "./header/RenderQueue.h"
+#include "./header/FrameData.h"
+#include "./header/SimClock.h"
+#include "./header/Headless.h"
+#include "./header/Profiler.h"
+#include "./header/FramePacer.h"
+#include "./header/BackgroundCache.h"
+#include "./header/ProgramCache.h"
+#include "./header/ShaderWatcher.h"
+#include "./header/JobSystem.h"
+#include "./header/TextureUploader.h"
+#include "./header/TextureCompress.h"
 #include "./header/stb_image.h"
 
 using namespace std;
 
 // 函式預告
 void framebufferSizeCallback(GLFWwindow *window, int width, int height);
+void windowRefreshCallback(GLFWwindow *window);
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void cursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 unsigned int createShader(const string &filename, const string &type);
+unsigned int compileShader(const string &code, const string &type);
 unsigned int createProgram(unsigned int vertexShader, unsigned int fragmentShader, unsigned int geometryShader = 0);
+unsigned int loadProgram(const string &name, const string &dir, const string &vsFile, const string &fsFile, const string &gsFile = "");
 unsigned int modelVAO(Object &model);
 unsigned int loadTexture(const string &filename);
+DecodedImage decodeImage(const string &filename);
+DecodedImage loadTextureImage(const string &filename, bool compress);
+unsigned int uploadTexture(const DecodedImage &image, const string &filename);
+Object *loadHand(const string &filename);
+void pollAssetLoading(bool wait);
 string resolveBase(const vector<string> &bases, const string &probeFile);
 void initBackground();
+void simulate(float dt);
+void renderFrame(double now);
+void submitHand(const glm::mat4 &view, const glm::mat4 &model, const glm::mat4 &mvp, float patternProgress);
+void reloadChangedShaders();
+bool sceneIsAnimating();
+int runHeadless(const HeadlessOptions &options);
+int runBackgroundBake(const HeadlessOptions &options);
+int runCompressTexture(const HeadlessOptions &options);
 
 // 全域變數
 int SCR_WIDTH = 800;
 int SCR_HEIGHT = 600;
-unsigned int shaderProgram;
+ShaderProgram shaderProgram;
 unsigned int handVAO, handTexture;
 Object *handObject;
 int fingerPainted[6] = { 0,0,0,0,0,0 };
+bool useInterleavedVertices = true; // 單一 VBO + 壓縮屬性格式 (24 bytes/vertex，含區域 tag)
+
+// 指甲裝飾：預先建立的 instance buffer + instanced draw；false 時改回 geometry shader 逐幀生成
+bool useInstancedDecorations = true;
+ShaderProgram handShaderProgram;       // 指甲上色（不經過 geometry shader）
+ShaderProgram skinShaderProgram;       // 皮膚與未上色的指甲：只取貼圖
+ShaderProgram decorationShaderProgram; // 鑽石 / 金字塔 / 星星
+DecorationRenderer decorations;
+
+// 已連結的 program 以 glGetProgramBinary 存在 shaders 目錄，下次啟動直接載入（原始碼或驅動改變時重新編譯）
+bool useProgramCache = true;
+ProgramCache programCache;
+
+// 每個 program 的來源檔；視窗模式下監看這些檔案，存檔後在兩幀之間重新編譯（連結失敗就保留舊的）
+struct ProgramSource
+{
+    string name;
+    ShaderProgram *program;
+    string vs, fs, gs;
+    bool usesFrameData;
+};
+vector<ProgramSource> programSources;
+string shaderDir;
+bool hotReloadShaders = true;
+ShaderWatcher shaderWatcher;
+
+// 非同步載入：worker 解析 OBJ、解碼貼圖，主執行緒照常畫背景，完成後才在主執行緒建立 VAO / texture
+bool asyncAssetLoading = true;
+JobSystem loaderJobs;
+future<Object *> pendingHand;
+future<DecodedImage> pendingHandTexture;
+bool handReady = false; // VAO、裝飾與貼圖都已建立，可以畫手
+
+// 貼圖經由 PBO ring 分幀上傳（每幀最多 textureUploadBudget bytes）；mipmap 在 worker 先算好，false 時改由 glGenerateMipmap 產生
+TextureUploader textureUploader;
+size_t textureUploadBudget = 8 << 20;
+bool buildMipsOnCPU = true;
+// 支援 S3TC 時貼圖以 BC1/BC3 放在 VRAM；第一次執行時壓縮並存成 <png>.texcache
+bool useCompressedTextures = true;
+chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
 
 // 背景相關
 unsigned int backgroundVAO;
-unsigned int backgroundShaderProgram;
+ShaderProgram backgroundShaderProgram; // 程序化木紋，只在解析度改變時執行
+ShaderProgram backgroundBlitProgram;   // 每幀把快取的木紋貼到畫面
+BackgroundCache backgroundCache;
+
+// 每幀的 draw item，以 64-bit key 排序（狀態分組、透明物件由後往前）
+RenderQueue renderQueue;
+
+// 每幀共用 uniform buffer（view/projection/time/手指狀態）
+FrameUniformBuffer frameUBO;
+
+// 每階段 CPU / GPU 計時（P 印出統計，T 錄製 Chrome trace）
+FrameProfiler profiler;
+const int TRACE_CAPTURE_FRAMES = 300;
+
+// 垂直同步、幀率上限與低延遲模式（--vsync / --max-fps / --low-latency）
+FramePacer framePacer;
 
 // 相機目標控制變數
 glm::vec3 currentCameraTarget(0.0f, 0.0f, 0.0f); 
@@ -57,10 +146,54 @@ float celebrateAngle = 0.0f;
 float cameraDistance = 13.0f;
 float cameraYaw = 0.0f;
 float cameraPitch = 135.0f;
+
+// 動畫時間（秒），原本以 60Hz 每幀固定增量換算而來
+const float PATTERN_GROW_SECONDS = 3.33f;    // 花紋生長：0.005 / 幀
+const float CELEBRATE_SPIN_SECONDS = 10.0f;  // 旋轉一圈：0.6 度 / 幀
+const float CAMERA_DAMPING_SECONDS = 0.325f; // 相機平滑時間常數：mix 0.05 / 幀
+
+// 固定步長模擬時鐘 + 畫面插值用的狀態
+SimClock simClock;
+struct SimState {
+    float patternProgress;
+    float celebrateAngle;
+    glm::vec3 cameraTarget;
+    float cameraDistance;
+    float cameraYaw;
+    float cameraPitch;
+};
+SimState prevSimState;
+
+// 閒置偵測：沒有動畫、相機已收斂、也沒有輸入時不重畫，改用 glfwWaitEventsTimeout 等事件
+bool idleWhenStatic = true;
+bool redrawRequested = true; // 輸入、視窗大小改變、shader 重載時設為 true，下一輪必定重畫
+const double IDLE_WAIT_SECONDS = 0.25; // 閒置時仍定期醒來檢查 shader 檔案
+const float CAMERA_REST_EPSILON = 1e-4f; // 相機與目標的差距小於此值視為靜止
+
 bool isRotating = false;
 double lastMouseX = 0.0;
 double lastMouseY = 0.0;
 
+SimState captureSimState() {
+    return { patternProgress, celebrateAngle, currentCameraTarget, cameraDistance, cameraYaw, cameraPitch };
+}
+
+// 在上一步與目前模擬狀態之間插值；不連續的變化（按鍵重設進度、角度繞回）直接採用目前值
+SimState interpolateSimState(const SimState &prev, const SimState &cur, float alpha) {
+    SimState s = cur;
+    if (cur.patternProgress >= prev.patternProgress) {
+        s.patternProgress = glm::mix(prev.patternProgress, cur.patternProgress, alpha);
+    }
+    float curAngle = cur.celebrateAngle;
+    if (curAngle < prev.celebrateAngle) curAngle += 360.0f;
+    s.celebrateAngle = glm::mix(prev.celebrateAngle, curAngle, alpha);
+    s.cameraTarget = glm::mix(prev.cameraTarget, cur.cameraTarget, alpha);
+    s.cameraDistance = glm::mix(prev.cameraDistance, cur.cameraDistance, alpha);
+    s.cameraYaw = glm::mix(prev.cameraYaw, cur.cameraYaw, alpha);
+    s.cameraPitch = glm::mix(prev.cameraPitch, cur.cameraPitch, alpha);
+    return s;
+}
+
 string resolveBase(const vector<string> &bases, const string &probeFile) {
     for (const auto &base : bases) {
         ifstream f(base + probeFile);
@@ -88,7 +221,7 @@ void initBackground() {
     glGenVertexArrays(1, &backgroundVAO);
     glGenBuffers(1, &VBO);
     
-    glBindVertexArray(backgroundVAO);
+    RenderState::current().bindVertexArray(backgroundVAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
     
@@ -109,33 +242,66 @@ void init() {
     string dirAsset = resolveBase(assetBases, "female_hand.obj");
     string dirTexture = resolveBase(textureBases, "female_hand.png");
 
-    cout << "Loading hand object..." << endl;
-    handObject = new Object(dirAsset + "female_hand.obj"); 
-    
     cout << "Compiling shaders..." << endl;
-    unsigned int vs = createShader(dirShader + "vertexShader.vert", "vert");
-    unsigned int fs = createShader(dirShader + "fragmentShader.frag", "frag");
-    unsigned int gs = createShader(dirShader + "geometryShader.geom", "geom");
-    shaderProgram = createProgram(vs, fs, gs);
+    auto compileStart = chrono::steady_clock::now();
+    programCache.enabled = useProgramCache;
+    programCache.init(dirShader);
+    shaderDir = dirShader;
+    programSources = {
+        { "hand_geometry", &shaderProgram, "vertexShader.vert", "fragmentShader.frag", "geometryShader.geom", true },
+        { "hand_nail", &handShaderProgram, "handShader.vert", "fragmentShader.frag", "", true },
+        { "hand_skin", &skinShaderProgram, "handShader.vert", "skinShader.frag", "", false },
+        { "decoration", &decorationShaderProgram, "decorationShader.vert", "fragmentShader.frag", "", true },
+        { "background", &backgroundShaderProgram, "backgroundShader.vert", "backgroundShader.frag", "", true },
+        { "background_blit", &backgroundBlitProgram, "backgroundShader.vert", "backgroundBlit.frag", "", false }
+    };
+    for (ProgramSource &src : programSources) {
+        src.program->reset(loadProgram(src.name, dirShader, src.vs, src.fs, src.gs));
+        if (src.usesFrameData) src.program->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+    }
+    double compileMs = chrono::duration<double, milli>(chrono::steady_clock::now() - compileStart).count();
+    cout << "Shaders ready in " << compileMs << " ms (" << programCache.hits << " from program cache, "
+         << programCache.misses << " compiled" << (programCache.active() ? "" : ", cache unavailable") << ")" << endl;
 
-    cout << "Creating VAO..." << endl;
-    handVAO = modelVAO(*handObject);
-    
-    cout << "Loading texture..." << endl;
-    handTexture = loadTexture(dirTexture + "female_hand.png");
-    
-    cout << "Compiling background shaders..." << endl;
-    unsigned int bgVS = createShader(dirShader + "backgroundShader.vert", "vert");
-    unsigned int bgFS = createShader(dirShader + "backgroundShader.frag", "frag");
-    backgroundShaderProgram = createProgram(bgVS, bgFS, 0);
+    string handFile = dirAsset + "female_hand.obj";
+    string handTextureFile = dirTexture + "female_hand.png";
+    if (asyncAssetLoading) {
+        cout << "Loading hand object and texture in the background..." << endl;
+        loaderJobs.start(2);
+        pendingHand = loaderJobs.submit([handFile]() { return loadHand(handFile); });
+        bool compress = useCompressedTextures && GLAD_GL_EXT_texture_compression_s3tc;
+        pendingHandTexture = loaderJobs.submit([handTextureFile, compress]() { return loadTextureImage(handTextureFile, compress); });
+    } else {
+        handObject = loadHand(handFile);
+        handVAO = modelVAO(*handObject);
+        decorations.build(*handObject);
+        handTexture = loadTexture(handTextureFile);
+        handReady = true;
+    }
+
+    frameUBO.create();
     
     cout << "Initializing background..." << endl;
     initBackground();
+    profiler.create();
+
+    prevSimState = captureSimState();
+    RenderState &state = RenderState::current();
+    state.depthTest(true);
+    state.cullFace(false);
+    state.blend(true);
+    state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     cout << "Initialization complete!" << endl;
 }
 
-int main() {
+int main(int argc, char **argv) {
+    HeadlessOptions headless;
+    if (!parseHeadlessArgs(argc, argv, headless)) return -1;
+    if (!headless.bakePath.empty()) return runBackgroundBake(headless);
+    if (!headless.compressPath.empty()) return runCompressTexture(headless);
+    if (headless.enabled) return runHeadless(headless);
+
     if (!glfwInit()) return -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -149,7 +315,21 @@ int main() {
     }
     
     glfwMakeContextCurrent(window);
+    FramePacing pacing = headless.pacing;
+    const GLFWvidmode *videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (videoMode && videoMode->refreshRate > 0) pacing.refreshHz = videoMode->refreshRate;
+    if (pacing.swapInterval < 0 && !glfwExtensionSupported("GLX_EXT_swap_control_tear")
+        && !glfwExtensionSupported("WGL_EXT_swap_control_tear")) {
+        cout << "Adaptive vsync not supported, using vsync" << endl;
+        pacing.swapInterval = 1;
+    }
+    glfwSwapInterval(pacing.swapInterval);
+    framePacer.configure(pacing);
+    cout << "Frame pacing: " << pacing.describe() << endl;
+    // 高 DPI 螢幕上 framebuffer 可能比視窗大，背景快取要用實際像素大小
+    glfwGetFramebufferSize(window, &SCR_WIDTH, &SCR_HEIGHT);
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
     glfwSetKeyCallback(window, keyCallback);
     glfwSetMouseButtonCallback(window, mouseButtonCallback);
     glfwSetCursorPosCallback(window, cursorPosCallback);
@@ -161,10 +341,16 @@ int main() {
     }
 
     init();
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (hotReloadShaders) {
+        vector<string> files;
+        for (const ProgramSource &src : programSources) {
+            for (const string &f : { src.vs, src.fs, src.gs }) {
+                if (!f.empty() && find(files.begin(), files.end(), f) == files.end()) files.push_back(f);
+            }
+        }
+        if (shaderWatcher.start(shaderDir, files)) cout << "Watching " << files.size() << " shader files for changes" << endl;
+        else cout << "Shader hot reload unavailable" << endl;
+    }
 
     cout << "\n=== Controls ===" << endl;
     cout << "A/B/C/D/E: Select finger (thumb/index/middle/ring/pinky)" << endl;
@@ -173,118 +359,438 @@ int main() {
     cout << "Mouse Wheel: Zoom in/out" << endl;
     cout << "Space: Reset View (Center)" << endl;
     cout << "Arrow Keys: Move Camera" << endl;
+    cout << "G: Print GL uniform call stats" << endl;
+    cout << "P: Print frame timings (CPU/GPU min/avg/p99)" << endl;
+    cout << "T: Capture a Chrome trace (frame_trace.json)" << endl;
     cout << "ESC: Exit" << endl;
 
+    bool firstFramePresented = false;
+    bool idle = false;
+    framePacer.inputSampled();
     while (!glfwWindowShouldClose(window)) {
-        float currentTime = (float)glfwGetTime();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // ===== 渲染木紋背景 =====
-        glDepthMask(GL_FALSE);
-        glUseProgram(backgroundShaderProgram);
-        glUniform1f(glGetUniformLocation(backgroundShaderProgram, "time"), currentTime);
-        glBindVertexArray(backgroundVAO);
+        if (hotReloadShaders) reloadChangedShaders();
+        pollAssetLoading(false);
+        // 畫面不會改變時不重畫，睡到有事件（或逾時）為止
+        if (idleWhenStatic && firstFramePresented && !redrawRequested && !sceneIsAnimating()) {
+            idle = true;
+            glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+            framePacer.inputSampled();
+            continue;
+        }
+        if (idle) {
+            // 閒置的時間不算進模擬，否則醒來第一幀會一次補上 0.25 秒
+            simClock.skipTo(glfwGetTime());
+            idle = false;
+        }
+        redrawRequested = false;
+        bool lowLatency = framePacer.pacing().lowLatency;
+        profiler.beginFrame();
+        if (lowLatency) {
+            // 低延遲：先等到接近下一次 present 才讀輸入，再立刻模擬與繪製
+            {
+                ProfileScope scope(profiler, PROFILE_PACING);
+                framePacer.waitForFrameStart();
+            }
+            glfwPollEvents();
+            framePacer.inputSampled();
+        }
+        renderFrame(glfwGetTime());
+        {
+            ProfileScope scope(profiler, PROFILE_SWAP);
+            if (lowLatency) {
+                // 等 GPU 做完再 swap，驅動就不會預先排好幾幀
+                glFinish();
+                framePacer.workFinished();
+            }
+            glfwSwapBuffers(window);
+        }
+        profiler.addInputAge(framePacer.framePresented());
+        if (!lowLatency) {
+            ProfileScope scope(profiler, PROFILE_PACING);
+            framePacer.waitForFrameStart();
+        }
+        profiler.endFrame();
+        if (!firstFramePresented) {
+            firstFramePresented = true;
+            cout << "First frame " << chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count()
+                 << " ms after start" << endl;
+        }
+        if (!lowLatency) {
+            glfwPollEvents();
+            framePacer.inputSampled();
+        }
+    }
+
+    profiler.finishTrace();
+    profiler.destroy();
+    textureUploader.destroy();
+    glfwTerminate();
+    return 0;
+}
+
+// 推進模擬並畫出一幀（背景 + 手部），now 為秒
+void renderFrame(double now) {
+    float currentTime = (float)now;
+    ShaderProgram::stats().reset();
+    profiler.begin(PROFILE_UPDATE);
+
+    // 以固定步長推進模擬，畫面使用插值後的狀態
+    int steps = simClock.advance(now);
+    for (int i = 0; i < steps; i++) {
+        prevSimState = captureSimState();
+        simulate(simClock.dt());
+    }
+    SimState renderState = interpolateSimState(prevSimState, captureSimState(), simClock.alpha());
+
+    // 計算相機位置與矩陣
+    float camX = renderState.cameraDistance * cos(glm::radians(renderState.cameraPitch)) * sin(glm::radians(renderState.cameraYaw));
+    float camY = renderState.cameraDistance * sin(glm::radians(renderState.cameraPitch));
+    float camZ = renderState.cameraDistance * cos(glm::radians(renderState.cameraPitch)) * cos(glm::radians(renderState.cameraYaw));
+
+    glm::vec3 cameraPos = renderState.cameraTarget + glm::vec3(camX, camY, camZ);
+    glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(cameraPos, renderState.cameraTarget, cameraUp);
+    glm::mat4 model = glm::mat4(1.0f);
+    model = glm::translate(model, glm::vec3(0.0f, -1.5f, 0.0f));
+    model = glm::rotate(model, glm::radians(-45.0f), glm::vec3(1, 0, 0));
+    if (celebrateSpin) {
+        model = glm::rotate(model, glm::radians(renderState.celebrateAngle), glm::vec3(0, 1, 0));
+    }
+    model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
+    // 頂點 / geometry shader 只做一次矩陣乘法
+    glm::mat4 mvp = projection * view * model;
+
+    // 每幀共用資料一次上傳到 UBO
+    FrameData frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.time = currentTime;
+    frame.activeFinger = activeFinger;
+    frame.patternProgress = renderState.patternProgress;
+    frame.pad0 = 0.0f;
+    for (int i = 0; i < 6; i++) {
+        frame.fingerPainted[i][0] = fingerPainted[i];
+        frame.fingerPainted[i][1] = frame.fingerPainted[i][2] = frame.fingerPainted[i][3] = 0;
+    }
+    frameUBO.update(frame);
+
+    // ===== 手部與指甲裝飾送進 render queue（排序後依 layer 畫出） =====
+    renderQueue.clear();
+    if (handReady) submitHand(view, model, mvp, renderState.patternProgress);
+    profiler.end(PROFILE_UPDATE);
+
+    // 綁定 / 開關狀態都經過 RenderState，沒變的呼叫不會送到 driver
+    RenderState &state = RenderState::current();
+    state.depthMask(true); // glClear 也受 depth mask 影響
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // ===== 渲染木紋背景 =====
+    profiler.begin(PROFILE_BACKGROUND);
+    state.bindVertexArray(backgroundVAO);
+    // 木紋與時間無關：只在 framebuffer 大小改變時重畫到快取 texture
+    bool hasBackground = backgroundCache.update(SCR_WIDTH, SCR_HEIGHT, []() {
+        RenderState::current().useProgram(backgroundShaderProgram);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        glDepthMask(GL_TRUE);
+    });
+    if (hasBackground) {
+        DrawItem blit;
+        blit.layer = RENDERLAYER::BACKGROUND;
+        blit.program = &backgroundBlitProgram;
+        blit.vao = backgroundVAO;
+        // 背景與手部貼圖各佔一個 texture unit，兩者每幀都不必重新綁定
+        blit.texture = backgroundCache.texture;
+        blit.textureUnit = 1;
+        blit.depthWrite = false;
+        blit.count = 6;
+        blit.setUniforms = [](ShaderProgram &program, const DrawItem &) {
+            static const ShaderProgram::UniformId backgroundTextureUniform = ShaderProgram::uniform("backgroundTexture");
+            program.setInt(backgroundTextureUniform, 1);
+        };
+        renderQueue.submit(blit);
+    }
+    renderQueue.draw(RENDERLAYER::BACKGROUND);
+    profiler.end(PROFILE_BACKGROUND);
 
-        // ===== 渲染手部 =====
-        glUseProgram(shaderProgram);
+    // ===== 渲染手部 =====
+    if (!handReady) return; // 還在載入：只畫背景
+    ProfileScope handScope(profiler, PROFILE_HAND);
+    renderQueue.draw(RENDERLAYER::SOLID);
+    renderQueue.draw(RENDERLAYER::TRANSLUCENT);
+}
 
-        // 更新花紋生長進度
-        if (isGrowing) {
-            patternProgress += 0.005f; 
-            if (patternProgress > 1.0f) {
-                isGrowing = false;
-                fingerPainted[activeFinger] = 1;
-                patternProgress = 0.0f;
-            }
+// 一隻手的 draw item：不透明的手部區段，加上半透明的指甲裝飾（由後往前畫）
+void submitHand(const glm::mat4 &view, const glm::mat4 &model, const glm::mat4 &mvp, float patternProgress) {
+    glm::mat4 modelView = view * model;
+    DrawItem item;
+    item.vao = handVAO;
+    item.texture = handTexture;
+    item.mvp = glm::value_ptr(mvp);
+    item.depth = -(modelView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)).z;
+    item.indexType = handObject->indexed ? handObject->indexType() : 0;
+    item.setUniforms = [](ShaderProgram &program, const DrawItem &) {
+        static const ShaderProgram::UniformId showPatternUniform = ShaderProgram::uniform("showPattern");
+        static const ShaderProgram::UniformId handTextureUniform = ShaderProgram::uniform("handTexture");
+        program.setInt(showPatternUniform, 1);
+        program.setInt(handTextureUniform, 0);
+    };
+
+    // 每個區段選一個 program：皮膚只取貼圖，上色中的指甲跑指甲 shader，
+    // 舊版 geometry shader 路徑只跑在需要裝飾的指甲上
+    ShaderProgram *regionProgram[HAND_REGION_COUNT];
+    regionProgram[REGION_SKIN] = &skinShaderProgram;
+    for (int finger = 1; finger < HAND_REGION_COUNT; finger++) {
+        bool painted = fingerPainted[finger] == 1 || activeFinger == finger;
+        regionProgram[finger] = !painted ? &skinShaderProgram
+            : (!useInstancedDecorations && finger <= DECORATION_KIND_COUNT) ? &shaderProgram : &handShaderProgram;
+    }
+
+    // 相鄰且使用同一個 program 的區段合併成一個 draw item
+    for (int r = 0; r < HAND_REGION_COUNT; ) {
+        item.program = regionProgram[r];
+        item.first = handObject->regions[r].first;
+        item.count = 0;
+        for (; r < HAND_REGION_COUNT && regionProgram[r] == item.program; r++) {
+            item.count += handObject->regions[r].count;
         }
+        renderQueue.submit(item);
+    }
 
-        // 全部完成後啟動旋轉展示
-        if (fingerPainted[1] && fingerPainted[2] && fingerPainted[3] && fingerPainted[4] && fingerPainted[5]) {
-            if (!celebrateSpin) {
-                celebrateSpin = true;
-                celebrateAngle = 0.0f;
-                cout << "All fingers finished! Celebrating spin..." << endl;
-            }
+    // ===== 指甲裝飾（正在生長或已完成的手指） =====
+    if (!useInstancedDecorations) return;
+    DrawItem decoration;
+    decoration.program = &decorationShaderProgram;
+    decoration.texture = handTexture;
+    decoration.mvp = glm::value_ptr(mvp);
+    for (int finger = 1; finger <= DECORATION_KIND_COUNT; finger++) {
+        bool finished = fingerPainted[finger] == 1;
+        bool growing = finger == activeFinger && patternProgress > 0.01f;
+        if (!finished && !growing) continue;
+        DECORATIONKIND kind = (DECORATIONKIND)finger;
+        decoration.depth = -(modelView * glm::vec4(decorations.center(kind), 1.0f)).z;
+        decorations.submit(renderQueue, decoration, kind, finished ? 1.0f : patternProgress, finished);
+    }
+}
+
+// 不需要任何輸入，下一幀也會和這一幀不同時回傳 true
+bool sceneIsAnimating() {
+    if (!handReady || textureUploader.busy()) return true; // 還在載入，要繼續 poll
+    if (isGrowing || celebrateSpin) return true;
+    if (fingerPainted[3] == 1) return true; // 完成的中指星星隨 time 持續旋轉
+    return glm::distance(currentCameraTarget, targetPos) > CAMERA_REST_EPSILON
+        || fabs(cameraDistance - targetDist) > CAMERA_REST_EPSILON
+        || fabs(cameraYaw - targetYaw) > CAMERA_REST_EPSILON
+        || fabs(cameraPitch - targetPitch) > CAMERA_REST_EPSILON;
+}
+
+// 固定步長模擬：花紋生長、完成旋轉、相機平滑（dt 單位為秒）
+void simulate(float dt) {
+    // 更新花紋生長進度
+    if (isGrowing) {
+        patternProgress += dt / PATTERN_GROW_SECONDS;
+        if (patternProgress > 1.0f) {
+            isGrowing = false;
+            fingerPainted[activeFinger] = 1;
+            patternProgress = 0.0f;
         }
+    }
 
-        if (celebrateSpin) {
-            celebrateAngle += 0.6f;
-            if (celebrateAngle >= 360.0f) {
-                celebrateAngle -= 360.0f;
-            }
+    // 全部完成後啟動旋轉展示
+    if (fingerPainted[1] && fingerPainted[2] && fingerPainted[3] && fingerPainted[4] && fingerPainted[5]) {
+        if (!celebrateSpin) {
+            celebrateSpin = true;
+            celebrateAngle = 0.0f;
+            cout << "All fingers finished! Celebrating spin..." << endl;
         }
+    }
 
-        // 判斷是否切換了手指
-        if (activeFinger != lastActiveFinger) {
-            if (activeFinger > 0) {
-                switch(activeFinger) {
-                    case 1: targetPos = glm::vec3(-1.0f, -1.5f, 0.0f); targetDist = 1.5f; break;
-                    case 2: targetPos = glm::vec3(-3.0f, 3.0f, 0.0f); targetDist = 1.5f; break;
-                    case 3: targetPos = glm::vec3(-4.5f, 3.0f, 0.0f); targetDist = 1.5f; break;
-                    case 4: targetPos = glm::vec3(-6.0f, 3.0f, 0.0f); targetDist = 1.5f; break;
-                    case 5: targetPos = glm::vec3(-7.2f, 1.2f, 0.0f); targetDist = 1.5f; break;
-                }
-            } else {
-                targetPos = glm::vec3(0.0f, 0.0f, 0.0f); 
-                targetDist = 13.0f;
-                targetYaw = 0.0f;
-                targetPitch = 135.0f;
+    if (celebrateSpin) {
+        celebrateAngle += dt * 360.0f / CELEBRATE_SPIN_SECONDS;
+        if (celebrateAngle >= 360.0f) {
+            celebrateAngle -= 360.0f;
+        }
+    }
+
+    // 判斷是否切換了手指
+    if (activeFinger != lastActiveFinger) {
+        if (activeFinger > 0) {
+            switch(activeFinger) {
+                case 1: targetPos = glm::vec3(-1.0f, -1.5f, 0.0f); targetDist = 1.5f; break;
+                case 2: targetPos = glm::vec3(-3.0f, 3.0f, 0.0f); targetDist = 1.5f; break;
+                case 3: targetPos = glm::vec3(-4.5f, 3.0f, 0.0f); targetDist = 1.5f; break;
+                case 4: targetPos = glm::vec3(-6.0f, 3.0f, 0.0f); targetDist = 1.5f; break;
+                case 5: targetPos = glm::vec3(-7.2f, 1.2f, 0.0f); targetDist = 1.5f; break;
             }
-            lastActiveFinger = activeFinger;
+        } else {
+            targetPos = glm::vec3(0.0f, 0.0f, 0.0f); 
+            targetDist = 13.0f;
+            targetYaw = 0.0f;
+            targetPitch = 135.0f;
         }
+        lastActiveFinger = activeFinger;
+    }
+
+    // 平滑插值（指數衰減，與幀率無關）
+    float k = dampFactor(CAMERA_DAMPING_SECONDS, dt);
+    currentCameraTarget = glm::mix(currentCameraTarget, targetPos, k);
+    cameraDistance = glm::mix(cameraDistance, targetDist, k);
+    cameraYaw = glm::mix(cameraYaw, targetYaw, k);
+    cameraPitch = glm::mix(cameraPitch, targetPitch, k);
+}
+
+// 無視窗模式：EGL context + FBO，依腳本輸入渲染並輸出每一幀
+int runHeadless(const HeadlessOptions &options) {
+#ifdef HAS_EGL_HEADLESS
+    vector<ScriptEvent> script;
+    bool scriptOk;
+    if (options.script.empty()) {
+        stringstream ss(defaultHeadlessScript());
+        scriptOk = parseScript(ss, script);
+    } else {
+        ifstream f(options.script);
+        if (!f.is_open()) { cout << "Failed to open script: " << options.script << endl; return -1; }
+        scriptOk = parseScript(f, script);
+    }
+    if (!scriptOk) return -1;
+
+    HeadlessContext context;
+    if (!context.create()) return -1;
+    if (!gladLoadGLLoader((GLADloadproc)HeadlessContext::getProcAddress)) {
+        cout << "Failed to initialize GLAD" << endl;
+        context.destroy();
+        return -1;
+    }
+    cout << "Headless renderer: " << glGetString(GL_RENDERER) << endl;
+
+    SCR_WIDTH = options.width;
+    SCR_HEIGHT = options.height;
+    OffscreenTarget target;
+    if (!target.create(options.width, options.height)) { context.destroy(); return -1; }
 
-        // 平滑插值
-        currentCameraTarget = glm::mix(currentCameraTarget, targetPos, 0.05f);
-        cameraDistance = glm::mix(cameraDistance, targetDist, 0.05f);
-        cameraYaw = glm::mix(cameraYaw, targetYaw, 0.05f);
-        cameraPitch = glm::mix(cameraPitch, targetPitch, 0.05f);
-
-        // 計算相機位置與矩陣
-        float camX = cameraDistance * cos(glm::radians(cameraPitch)) * sin(glm::radians(cameraYaw));
-        float camY = cameraDistance * sin(glm::radians(cameraPitch));
-        float camZ = cameraDistance * cos(glm::radians(cameraPitch)) * cos(glm::radians(cameraYaw));
-
-        glm::vec3 cameraPos = currentCameraTarget + glm::vec3(camX, camY, camZ);
-        glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
-
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 1000.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, currentCameraTarget, cameraUp);
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, -1.5f, 0.0f));
-        model = glm::rotate(model, glm::radians(-45.0f), glm::vec3(1, 0, 0));
-        if (celebrateSpin) {
-            model = glm::rotate(model, glm::radians(celebrateAngle), glm::vec3(0, 1, 0));
+    init();
+    pollAssetLoading(true); // 腳本從第 0 幀就要看到手，輸出才會固定
+    if (!options.tracePath.empty()) profiler.captureTrace(options.tracePath, options.frames > 0 ? options.frames : 1 << 30);
+    // 腳本時間每幀固定前進 1/fps，不需要限制單幀模擬時間
+    simClock = SimClock(1.0 / 120.0, 1.0 / options.fps + 1.0);
+
+    // 腳本時間固定步進，輸出與實際執行速度無關
+    size_t nextEvent = 0;
+    vector<unsigned char> pixels;
+    for (int frame = 0; options.frames <= 0 || frame < options.frames; frame++) {
+        double now = frame / (double)options.fps;
+        bool ended = false;
+        for (; nextEvent < script.size() && script[nextEvent].time <= now; nextEvent++) {
+            const ScriptEvent &e = script[nextEvent];
+            if (e.command == "key") {
+                keyCallback(NULL, e.key, 0, GLFW_PRESS, 0);
+            } else if (e.command == "orbit") {
+                targetYaw += e.a;
+                targetPitch += e.b;
+            } else if (e.command == "zoom") {
+                scrollCallback(NULL, 0.0, e.a);
+            } else if (e.command == "end") {
+                ended = true;
+            }
         }
-        model = glm::scale(model, glm::vec3(0.5f, 0.5f, 0.5f));
+        if (ended || (options.frames <= 0 && nextEvent >= script.size())) break;
 
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        profiler.beginFrame();
+        renderFrame(now);
+        bool written;
+        {
+            // 無視窗時以讀回 + 寫檔代替 swap
+            ProfileScope scope(profiler, PROFILE_SWAP);
+            target.readPixels(pixels);
+            written = writeFrame(options.outDir, frame, options.format, target.width, target.height, pixels);
+        }
+        profiler.endFrame();
+        if (!written) {
+            cout << "Failed to write frame " << frame << " to " << options.outDir << endl;
+            context.destroy();
+            return -1;
+        }
+    }
 
-        glUniform1i(glGetUniformLocation(shaderProgram, "activeFinger"), activeFinger);
-        glUniform1f(glGetUniformLocation(shaderProgram, "patternProgress"), patternProgress);
-        glUniform1f(glGetUniformLocation(shaderProgram, "time"), currentTime);
-        glUniform1i(glGetUniformLocation(shaderProgram, "showPattern"), 1);
-        glUniform1iv(glGetUniformLocation(shaderProgram, "fingerPainted"), 6, fingerPainted);
+    cout << "Headless rendering finished." << endl;
+    profiler.finishTrace();
+    profiler.printStats();
+    profiler.destroy();
+    textureUploader.destroy();
+    context.destroy();
+    return 0;
+#else
+    cout << "Headless mode needs EGL, which was not found at build time." << endl;
+    return -1;
+#endif
+}
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, handTexture);
-        glUniform1i(glGetUniformLocation(shaderProgram, "handTexture"), 0);
+// 以 CPU 產生木紋背景並存成圖片（不需要 OpenGL）
+int runBackgroundBake(const HeadlessOptions &options) {
+    vector<unsigned char> pixels;
+    WOODSIMD simd = resolveWoodSimd(options.simd);
+    auto start = chrono::steady_clock::now();
+    bakeWoodTexture(options.width, options.height, pixels, options.threads, simd);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Baked " << options.width << "x" << options.height << " wood background (" << woodSimdName(simd)
+        << ") in " << seconds * 1000.0 << " ms" << endl;
 
-        glBindVertexArray(handVAO);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)handObject->positions.size() / 3);
+    stbi_flip_vertically_on_write(1); // 木紋是 GL 列順序（最下面一列在前）
+    bool ok = stbi_write_png(options.bakePath.c_str(), options.width, options.height, 4, pixels.data(), options.width * 4) != 0;
+    stbi_flip_vertically_on_write(0);
+    if (!ok) {
+        cout << "Failed to write " << options.bakePath << endl;
+        return -1;
+    }
+    return 0;
+}
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+// 離線轉檔：寫出 <image>.texcache（不需要 OpenGL），並印出大小與 level 0 的 PSNR
+int runCompressTexture(const HeadlessOptions &options) {
+    DecodedImage image = decodeImage(options.compressPath);
+    if (image.empty()) {
+        cout << "Failed to load texture: " << options.compressPath << endl;
+        return -1;
+    }
+    buildMipChain(image);
+    DecodedImage compressed = compressImage(image);
+    if (!writeTextureCache(options.compressPath, compressed)) {
+        cout << "Failed to write texture cache: " << textureCachePath(options.compressPath) << endl;
+        return -1;
     }
 
-    glfwTerminate();
+    size_t rawBytes = 0, blockBytes = 0;
+    for (const MipLevel &l : image.levels) rawBytes += l.pixels.size();
+    for (const MipLevel &l : compressed.levels) blockBytes += l.pixels.size();
+    // 解回 level 0 的 BC1 / BC3 色彩計算誤差
+    const MipLevel &src = image.levels[0], &blocks = compressed.levels[0];
+    int bw = (src.width + 3) / 4, c = image.channels, blockSize = compressedBlockBytes(compressed.compressedFormat);
+    double sqErr = 0.0;
+    for (int y = 0; y < src.height; y++) {
+        for (int x = 0; x < src.width; x++) {
+            const unsigned char *b = &blocks.pixels[((size_t)(y / 4) * bw + x / 4) * blockSize + (c == 4 ? 8 : 0)];
+            int p[4][3];
+            unpackRGB565((uint16_t)(b[0] | b[1] << 8), p[0]);
+            unpackRGB565((uint16_t)(b[2] | b[3] << 8), p[1]);
+            for (int k = 0; k < 3; k++) { p[2][k] = (2 * p[0][k] + p[1][k]) / 3; p[3][k] = (p[0][k] + 2 * p[1][k]) / 3; }
+            int i = (y % 4) * 4 + x % 4;
+            int idx = (b[4 + i / 4] >> (2 * (i % 4))) & 3;
+            for (int k = 0; k < 3; k++) {
+                double d = src.pixels[((size_t)y * src.width + x) * c + k] - p[idx][k];
+                sqErr += d * d;
+            }
+        }
+    }
+    double mse = sqErr / ((double)src.width * src.height * 3);
+    cout << "Wrote " << textureCachePath(options.compressPath) << ": " << src.width << "x" << src.height << ", "
+         << compressed.levels.size() << " levels, " << (c == 4 ? "BC3" : "BC1") << ", " << blockBytes / 1024 << " KB (was "
+         << rawBytes / 1024 << " KB), PSNR " << (mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0) << " dB" << endl;
     return 0;
 }
 
 void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    redrawRequested = true;
     if (action == GLFW_PRESS || action == GLFW_REPEAT) {
         float moveSpeed = 0.2f; 
         
@@ -308,6 +814,28 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
                 }
                 break;
 
+            case GLFW_KEY_G: {
+                // 上一幀實際送出的 uniform 呼叫數（舊版每幀 ~12 次 glGetUniformLocation + ~12 次 glUniform*）
+                const GLCallStats &st = ShaderProgram::stats();
+                cout << "GL uniform calls last frame: " << st.uniformUploads << " uploaded, "
+                     << st.uniformsSkipped << " skipped (unchanged), "
+                     << st.locationQueries << " location queries" << endl;
+                cout << "GL state calls last frame: " << st.stateCalls << " issued, "
+                     << st.stateSkipped << " skipped (already set)" << endl;
+                cout << "Render queue last frame: " << renderQueue.size() << " items, "
+                     << renderQueue.sortPasses() << " radix passes" << endl;
+                break;
+            }
+
+            case GLFW_KEY_P:
+                cout << "Frame pacing: " << framePacer.pacing().describe() << endl;
+                profiler.printStats();
+                break;
+
+            case GLFW_KEY_T:
+                profiler.captureTrace("frame_trace.json", TRACE_CAPTURE_FRAMES);
+                break;
+
             case GLFW_KEY_ESCAPE: 
                 glfwSetWindowShouldClose(window, true); 
                 break;
@@ -328,6 +856,7 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
 }
 
 void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    redrawRequested = true;
     if (button == GLFW_MOUSE_BUTTON_LEFT) {
         if (action == GLFW_PRESS) {
             isRotating = true;
@@ -340,6 +869,7 @@ void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
 
 void cursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
     if (isRotating) {
+        redrawRequested = true;
         double deltaX = xpos - lastMouseX;
         double deltaY = ypos - lastMouseY;
         
@@ -355,6 +885,7 @@ void cursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+    redrawRequested = true;
     targetDist -= yoffset * 0.5f;
     if (targetDist < 1.0f) targetDist = 1.0f; 
 }
@@ -363,12 +894,23 @@ void framebufferSizeCallback(GLFWwindow *window, int width, int height) {
     glViewport(0, 0, width, height);
     SCR_WIDTH = width;
     SCR_HEIGHT = height;
+    redrawRequested = true;
+}
+
+// 視窗被遮住後重新露出等情況，系統要求重畫內容
+void windowRefreshCallback(GLFWwindow *window) {
+    redrawRequested = true;
 }
 
 unsigned int createShader(const string &filename, const string &type) {
     ifstream f(filename);
     if (!f.is_open()) { cout << "Failed to open shader: " << filename << endl; return 0; }
-    stringstream ss; ss << f.rdbuf(); string code = ss.str(); const char* src = code.c_str();
+    stringstream ss; ss << f.rdbuf();
+    return compileShader(ss.str(), type);
+}
+
+unsigned int compileShader(const string &code, const string &type) {
+    const char* src = code.c_str();
     GLenum shaderType; if (type == "vert") shaderType = GL_VERTEX_SHADER; else if (type == "geom") shaderType = GL_GEOMETRY_SHADER; else shaderType = GL_FRAGMENT_SHADER;
     unsigned int shader = glCreateShader(shaderType); glShaderSource(shader, 1, &src, NULL); glCompileShader(shader);
     int success; glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -381,37 +923,204 @@ unsigned int createProgram(unsigned int vs, unsigned int fs, unsigned int gs) {
     glAttachShader(prog, vs); 
     glAttachShader(prog, fs);
     if (gs != 0) glAttachShader(prog, gs);
+    programCache.prepare(prog);
     glLinkProgram(prog);
     int success; glGetProgramiv(prog, GL_LINK_STATUS, &success);
-    if (!success) { char infoLog[512]; glGetProgramInfoLog(prog, 512, NULL, infoLog); cout << "Program link error: " << infoLog << endl; return 0; }
     glDeleteShader(vs); glDeleteShader(fs); if (gs != 0) glDeleteShader(gs);
+    if (!success) { char infoLog[512]; glGetProgramInfoLog(prog, 512, NULL, infoLog); cout << "Program link error: " << infoLog << endl; glDeleteProgram(prog); return 0; }
     return prog;
 }
 
+// 先查 program binary 快取；沒有或驅動不接受時從原始碼編譯，再寫回快取
+unsigned int loadProgram(const string &name, const string &dir, const string &vsFile, const string &fsFile, const string &gsFile) {
+    const string files[3] = { vsFile, fsFile, gsFile };
+    const GLenum types[3] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+    vector<ShaderSource> stages;
+    for (int i = 0; i < 3; i++) {
+        if (files[i].empty()) continue;
+        ifstream f(dir + files[i]);
+        if (!f.is_open()) { cout << "Failed to open shader: " << dir + files[i] << endl; return 0; }
+        stringstream ss; ss << f.rdbuf();
+        stages.push_back({ types[i], ss.str() });
+    }
+
+    uint64_t key = programCache.key(stages);
+    unsigned int prog = programCache.load(name, key);
+    if (prog != 0) return prog;
+
+    unsigned int vs = compileShader(stages[0].code, "vert");
+    unsigned int fs = compileShader(stages[1].code, "frag");
+    unsigned int gs = stages.size() > 2 ? compileShader(stages[2].code, "geom") : 0;
+    if (vs == 0 || fs == 0 || (stages.size() > 2 && gs == 0)) {
+        glDeleteShader(vs); glDeleteShader(fs); glDeleteShader(gs);
+        return 0;
+    }
+    prog = createProgram(vs, fs, gs);
+    if (prog != 0 && programCache.active() && !programCache.store(name, key, prog)) {
+        cout << "Failed to write program cache: " << name << endl;
+    }
+    return prog;
+}
+
+// 在兩幀之間呼叫：改動過的 program 重新建立，成功才換掉舊的
+void reloadChangedShaders() {
+    vector<string> changed = shaderWatcher.poll();
+    if (changed.empty()) return;
+    for (ProgramSource &src : programSources) {
+        bool affected = false;
+        for (const string &f : changed) affected = affected || f == src.vs || f == src.fs || f == src.gs;
+        if (!affected) continue;
+
+        unsigned int prog = loadProgram(src.name, shaderDir, src.vs, src.fs, src.gs);
+        if (prog == 0) {
+            cout << "Reload of " << src.name << " failed, keeping the previous program" << endl;
+            continue;
+        }
+        glDeleteProgram(src.program->id);
+        src.program->reset(prog);
+        if (src.usesFrameData) src.program->bindUniformBlock("FrameData", FRAME_DATA_BINDING);
+        if (src.program == &backgroundShaderProgram) backgroundCache.invalidate();
+        redrawRequested = true;
+        cout << "Reloaded " << src.name << endl;
+    }
+}
+
 unsigned int modelVAO(Object &model) {
-    unsigned int VAO, VBO[3]; glGenVertexArrays(1, &VAO); glGenBuffers(3, VBO); glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[0]); glBufferData(GL_ARRAY_BUFFER, model.positions.size() * sizeof(float), &model.positions[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
-    if (!model.normals.empty()) { glBindBuffer(GL_ARRAY_BUFFER, VBO[1]); glBufferData(GL_ARRAY_BUFFER, model.normals.size() * sizeof(float), &model.normals[0], GL_STATIC_DRAW); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); glEnableVertexAttribArray(1); }
-    glBindBuffer(GL_ARRAY_BUFFER, VBO[2]); glBufferData(GL_ARRAY_BUFFER, model.texcoords.size() * sizeof(float), &model.texcoords[0], GL_STATIC_DRAW);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0); glEnableVertexAttribArray(2);
+    unsigned int VAO; glGenVertexArrays(1, &VAO); RenderState::current().bindVertexArray(VAO);
+
+    if (useInterleavedVertices) {
+        // position float3 + normal 2_10_10_10 + uv (ushort normalized，超出 [0,1] 時改用 half) + 區域 tag (uint8)
+        VertexLayout layout;
+        layout.add(0, ATTRIBSOURCE::POSITION, ATTRIBFORMAT::FLOAT3)
+              .add(1, ATTRIBSOURCE::NORMAL, ATTRIBFORMAT::INT_2_10_10_10)
+              .add(2, ATTRIBSOURCE::TEXCOORD, model.texcoordsInUnitRange() ? ATTRIBFORMAT::USHORT2_NORM : ATTRIBFORMAT::HALF2);
+        if (!model.tags.empty()) {
+            layout.add(3, ATTRIBSOURCE::TAG, ATTRIBFORMAT::UBYTE_INT);
+        }
+        vector<unsigned char> vertices = model.interleave(layout);
+
+        unsigned int VBO; glGenBuffers(1, &VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO); glBufferData(GL_ARRAY_BUFFER, vertices.size(), vertices.data(), GL_STATIC_DRAW);
+        layout.apply();
+    } else {
+        unsigned int VBO[3]; glGenBuffers(3, VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[0]); glBufferData(GL_ARRAY_BUFFER, model.positions.size() * sizeof(float), &model.positions[0], GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); glEnableVertexAttribArray(0);
+        if (!model.normals.empty()) { glBindBuffer(GL_ARRAY_BUFFER, VBO[1]); glBufferData(GL_ARRAY_BUFFER, model.normals.size() * sizeof(float), &model.normals[0], GL_STATIC_DRAW); glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); glEnableVertexAttribArray(1); }
+        glBindBuffer(GL_ARRAY_BUFFER, VBO[2]); glBufferData(GL_ARRAY_BUFFER, model.texcoords.size() * sizeof(float), &model.texcoords[0], GL_STATIC_DRAW);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0); glEnableVertexAttribArray(2);
+        if (!model.tags.empty()) { unsigned int tagVBO; glGenBuffers(1, &tagVBO); glBindBuffer(GL_ARRAY_BUFFER, tagVBO); glBufferData(GL_ARRAY_BUFFER, model.tags.size(), model.tags.data(), GL_STATIC_DRAW); glVertexAttribIPointer(3, 1, GL_UNSIGNED_BYTE, 1, (void*)0); glEnableVertexAttribArray(3); }
+    }
+
+    // 索引模式：上傳 element buffer（頂點數夠少時用 16-bit 索引）
+    if (model.indexed) {
+        unsigned int EBO; glGenBuffers(1, &EBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        if (model.indexType() == GL_UNSIGNED_SHORT) {
+            vector<unsigned short> indices16(model.indices.begin(), model.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices16.size() * sizeof(unsigned short), indices16.data(), GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, model.indices.size() * sizeof(unsigned int), model.indices.data(), GL_STATIC_DRAW);
+        }
+    }
     return VAO;
 }
 
 unsigned int loadTexture(const string &filename) {
-    unsigned int textureID; glGenTextures(1, &textureID);
-    int width, height, nrComponents; stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+    return uploadTexture(decodeImage(filename), filename);
+}
+
+// 只做解碼（不碰 GL），可以在 worker 執行；flip 設定是 per-thread
+DecodedImage decodeImage(const string &filename) {
+    DecodedImage image;
+    MipLevel base;
+    stbi_set_flip_vertically_on_load_thread(1);
+    // 上傳與 S3TC 壓縮都只處理 RGB / RGBA：灰階展開成 RGB，灰階 + alpha 展開成 RGBA
+    int fileChannels = 0;
+    int channels = stbi_info(filename.c_str(), &base.width, &base.height, &fileChannels)
+        && (fileChannels == 2 || fileChannels == 4) ? 4 : 3;
+    unsigned char *data = stbi_load(filename.c_str(), &base.width, &base.height, &fileChannels, channels);
     if (data) {
-        GLenum format = (nrComponents == 4) ? GL_RGBA : GL_RGB;
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        image.channels = channels;
+        base.pixels.assign(data, data + (size_t)base.width * base.height * image.channels);
+        stbi_image_free(data);
+        image.levels.push_back(move(base));
+    }
+    return image;
+}
+
+// 給 worker 用：compress 時先找壓縮快取，沒有才解碼、建 mipmap、壓縮並寫回快取
+DecodedImage loadTextureImage(const string &filename, bool compress) {
+    DecodedImage image;
+    bool stale = false;
+    if (compress && readTextureCache(filename, image, stale)) {
+        cout << "Loaded texture cache: " << textureCachePath(filename) << endl;
+        if (stale) writeTextureCache(filename, image); // 內容沒變，只更新 mtime
+        return image;
+    }
+    image = decodeImage(filename);
+    if (image.empty()) return image;
+    if (buildMipsOnCPU || compress) buildMipChain(image);
+    if (compress) {
+        image = compressImage(image);
+        if (!writeTextureCache(filename, image)) cerr << "Failed to write texture cache: " << textureCachePath(filename) << endl;
+    }
+    return image;
+}
+
+unsigned int uploadTexture(const DecodedImage &image, const string &filename) {
+    unsigned int textureID; glGenTextures(1, &textureID);
+    if (!image.empty()) {
+        GLenum format = (image.channels == 4) ? GL_RGBA : GL_RGB;
+        RenderState::current().bindTextureForUpload(textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, format, image.width(), image.height(), 0, format, GL_UNSIGNED_BYTE, image.levels[0].pixels.data());
         glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        stbi_image_free(data);
     } else { cout << "Failed to load texture: " << filename << endl; }
     return textureID;
+}
+
+// 讀取並整理手部模型（只做 CPU 工作，可以在 worker 執行）
+Object *loadHand(const string &filename) {
+    ObjectLoadOptions handOptions;
+    handOptions.indexed = true;
+    handOptions.useCache = true;
+    handOptions.parallelParse = true;
+    Object *hand = new Object(filename, handOptions);
+    // 每個三角形的手指 / 指甲區域只在載入時判斷一次，存在 provoking vertex 的 tag
+    size_t splitVertices = tagHandVertices(*hand);
+    // 三角形依區域排序：皮膚、各手指指甲（之後可以分段繪製）
+    partitionHandRegions(*hand);
+    cout << "Tagged hand regions (" << splitVertices << " border vertices split)" << endl;
+    cout << "Hand regions: " << hand->regions[REGION_SKIN].count / 3 << " skin triangles, "
+         << (hand->drawCount() - hand->regions[REGION_SKIN].count) / 3 << " nail triangles" << endl;
+    return hand;
+}
+
+// 每幀在主執行緒呼叫：把已完成的載入結果上傳到 GL；wait 為 true 時等到全部完成
+void pollAssetLoading(bool wait) {
+    if (pendingHand.valid() && (wait || isReady(pendingHand))) {
+        handObject = pendingHand.get();
+        handVAO = modelVAO(*handObject);
+        decorations.build(*handObject);
+    }
+    if (pendingHandTexture.valid() && (wait || isReady(pendingHandTexture))) {
+        DecodedImage image = pendingHandTexture.get();
+        // 解碼失敗時 handTexture 維持 0：照樣算載入完成，手以無貼圖的樣子畫出
+        if (image.empty()) cout << "Failed to load texture: female_hand.png" << endl;
+        else handTexture = textureUploader.begin(move(image));
+    }
+    if (wait) textureUploader.finish();
+    else textureUploader.update(textureUploadBudget);
+    bool textureDone = handTexture == 0 || textureUploader.isComplete(handTexture);
+    if (!handReady && handObject != NULL && !pendingHandTexture.valid() && textureDone) {
+        handReady = true;
+        redrawRequested = true;
+        loaderJobs.stop();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+        cout << "Hand assets ready " << ms << " ms after start" << endl;
+    }
 }
\ No newline at end of file
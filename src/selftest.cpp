@@ -0,0 +1,689 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstddef>
+#include <algorithm>
+#include <thread>
+
+#include "./header/Object.h"
+#include "./header/RenderQueue.h"
+#include "./header/TextureCompress.h"
+#include "./header/WoodTexture.h"
+
+using namespace std;
+
+// 自我檢查（不需要 OpenGL 或視窗，只用到 header-only 的程式碼）
+//   ICG_2025_HW2_selftest            跑全部檢查（不含 bench-*）
+//   ICG_2025_HW2_selftest NAME...    只跑指定的項目
+//   --out DIR                        暫存檔的目錄（預設目前目錄）
+//   --size WxH                       bench-background 的解析度（預設 1280x720）
+// 任何一項失敗時結束碼不為 0
+
+// 函式預告
+string assetPath(const string &file);
+int runMeshSelfTest();
+int runPackingSelfTest();
+int runMeshCacheSelfTest();
+int runMeshCacheBench();
+size_t writeSyntheticObj(const string &path, int columns, int rows, int rowsPerGroup);
+bool sameShapes(const vector<tinyobj::shape_t> &a, const vector<tinyobj::shape_t> &b);
+int runObjParseBench();
+bool writeMixedObj(const string &path, int blocks, bool crlf);
+int runObjParallelSelfTest();
+int runTextureCacheSelfTest();
+int runRenderQueueSelfTest();
+int runBackgroundBench();
+
+// 名稱與對應的檢查；benchmark 是效能量測，只有指名時才跑
+struct SelfTest
+{
+    const char *name;
+    int (*run)();
+    bool benchmark;
+};
+
+const SelfTest selfTests[] = {
+    { "mesh", runMeshSelfTest, false },
+    { "packing", runPackingSelfTest, false },
+    { "mesh-cache", runMeshCacheSelfTest, false },
+    { "obj-parallel", runObjParallelSelfTest, false },
+    { "texture-cache", runTextureCacheSelfTest, false },
+    { "render-queue", runRenderQueueSelfTest, false },
+    { "bench-mesh-cache", runMeshCacheBench, true },
+    { "bench-obj-parse", runObjParseBench, true },
+    { "bench-background", runBackgroundBench, true },
+};
+
+// 命令列選項
+struct SelfTestOptions
+{
+    string outDir = ".";  // --out：暫存檔（合成 / 混合寫法的 OBJ）寫在這裡，跑完就刪掉
+    int width = 1280;     // --size：CPU 木紋背景的大小
+    int height = 720;
+};
+
+SelfTestOptions selfTestOptions;
+
+// 與 main.cpp 的 init() 相同的搜尋順序
+string assetPath(const string &file) {
+    vector<string> assetBases = { "../../src/asset/obj/", "../src/asset/obj/", "src/asset/obj/" };
+    for (const auto &base : assetBases) {
+        ifstream f(base + file);
+        if (f.good()) return base + file;
+    }
+    return assetBases.front() + file;
+}
+
+// 索引化載入的檢查：female_hand.obj 的角點數與合併後的頂點數，以及每個三角形都與未索引版本逐位元相同
+int runMeshSelfTest() {
+    const size_t HAND_CORNERS = 32352;
+    const size_t HAND_WELDED_VERTICES = 7599;
+
+    string file = assetPath("female_hand.obj");
+    Object flat(file, false);
+    Object indexed(file, true);
+    if (flat.positions.empty() || indexed.positions.empty()) {
+        cout << "Failed to load " << file << endl;
+        return 1;
+    }
+
+    int failures = 0;
+    size_t corners = flat.positions.size() / 3, vertices = indexed.positions.size() / 3;
+    printf("  corners %zu (expected %zu), welded vertices %zu (expected %zu), indices %zu\n",
+        corners, HAND_CORNERS, vertices, HAND_WELDED_VERTICES, indexed.indices.size());
+    if (corners != HAND_CORNERS || vertices != HAND_WELDED_VERTICES || indexed.indices.size() != corners) failures++;
+
+    size_t triangles = min(corners, indexed.indices.size()) / 3, badTriangles = 0;
+    for (size_t t = 0; t < triangles; t++) {
+        bool same = true;
+        for (size_t a = t * 3; a < t * 3 + 3 && same; a++) {
+            unsigned int b = indexed.indices[a];
+            same = b < vertices
+                && memcmp(&flat.positions[a * 3], &indexed.positions[b * 3], 3 * sizeof(float)) == 0
+                && memcmp(&flat.normals[a * 3], &indexed.normals[b * 3], 3 * sizeof(float)) == 0
+                && memcmp(&flat.texcoords[a * 2], &indexed.texcoords[b * 2], 2 * sizeof(float)) == 0;
+        }
+        if (!same) {
+            if (badTriangles == 0) printf("  first mismatch at triangle %zu\n", t);
+            badTriangles++;
+        }
+    }
+    printf("  %zu of %zu triangles differ between indexed and de-indexed\n", badTriangles, triangles);
+    if (badTriangles) failures++;
+    return failures;
+}
+
+// 頂點壓縮格式的來回誤差檢查：先掃過整個數值範圍，再檢查手模型實際 interleave 出來的資料
+int runPackingSelfTest() {
+    int failures = 0;
+    auto check = [&failures](const char *name, double maxError, double bound) {
+        bool ok = maxError <= bound;
+        printf("  %-30s max error %.3g (bound %.3g)  %s\n", name, maxError, bound, ok ? "ok" : "FAIL");
+        if (!ok) failures++;
+    };
+    // 誤差本身以 float 計算，容許多一點捨入
+    const double SNORM10_BOUND = 0.5 / 511.0 + 1e-6;
+    const double UNORM16_BOUND = 0.5 / 65535.0 + 1e-7;
+    const double HALF_RELATIVE_BOUND = 1.0 / 2048.0;  // 2^-11
+    const double HALF_SUBNORMAL_BOUND = ldexp(1.0, -25);
+
+    const int STEPS = 1 << 20;
+    double snormError = 0.0, unormError = 0.0;
+    for (int i = 0; i <= STEPS; i++) {
+        float t = (float)i / STEPS, s = t * 2.0f - 1.0f;
+        snormError = max(snormError, (double)fabsf(unpackSnorm10(packSnorm10(s)) - s));
+        unormError = max(unormError, (double)fabsf(unpackUnorm16(packUnorm16(t)) - t));
+    }
+    check("snorm10 sweep [-1, 1]", snormError, SNORM10_BOUND);
+    check("unorm16 sweep [0, 1]", unormError, UNORM16_BOUND);
+
+    // half：正規範圍看相對誤差，subnormal 看絕對誤差（兩者都是半個 ulp）
+    double halfError = 0.0, subnormalError = 0.0;
+    uint32_t lowest, highest;
+    float smallestNormal = ldexpf(1.0f, -14), largest = 65504.0f;
+    memcpy(&lowest, &smallestNormal, 4);
+    memcpy(&highest, &largest, 4);
+    for (uint32_t bits = lowest; bits <= highest; bits += 7) {
+        float f; memcpy(&f, &bits, 4);
+        halfError = max(halfError, fabs((double)halfToFloat(floatToHalf(f)) - f) / f);
+    }
+    for (int i = 0; i <= STEPS; i++) {
+        float f = smallestNormal * i / STEPS;
+        subnormalError = max(subnormalError, fabs((double)halfToFloat(floatToHalf(-f)) + f));
+    }
+    check("half sweep, normal range", halfError, HALF_RELATIVE_BOUND);
+    check("half sweep, subnormals", subnormalError, HALF_SUBNORMAL_BOUND);
+
+    // 每個非 NaN 的 half 轉成 float 再轉回來都要一模一樣
+    int halfMismatches = 0;
+    for (uint32_t h = 0; h <= 0xFFFFu; h++) {
+        bool nan = (h & 0x7C00u) == 0x7C00u && (h & 0x3FFu) != 0;
+        if (!nan && floatToHalf(halfToFloat((uint16_t)h)) != h) halfMismatches++;
+    }
+    printf("  %-30s %d of 65536 bit patterns differ  %s\n", "half -> float -> half", halfMismatches, halfMismatches ? "FAIL" : "ok");
+    if (halfMismatches) failures++;
+
+    // 手模型：與 modelVAO 相同的 layout，把 interleave 的結果解回來和原始資料比較
+    string file = assetPath("female_hand.obj");
+    Object hand(file, true);
+    if (hand.positions.empty()) {
+        cout << "Failed to load " << file << endl;
+        return failures + 1;
+    }
+    bool unitUv = hand.texcoordsInUnitRange();
+    VertexLayout layout;
+    layout.add(0, ATTRIBSOURCE::POSITION, ATTRIBFORMAT::FLOAT3)
+          .add(1, ATTRIBSOURCE::NORMAL, ATTRIBFORMAT::INT_2_10_10_10)
+          .add(2, ATTRIBSOURCE::TEXCOORD, unitUv ? ATTRIBFORMAT::USHORT2_NORM : ATTRIBFORMAT::HALF2);
+    vector<unsigned char> vertices = hand.interleave(layout);
+    size_t vertexCount = hand.positions.size() / 3;
+    double positionError = 0.0, normalError = 0.0, uvError = 0.0;
+    for (size_t i = 0; i < vertexCount; i++) {
+        const unsigned char *v = &vertices[i * layout.stride];
+        float position[3]; uint32_t normal; uint16_t uv[2];
+        memcpy(position, v + layout.attribs[0].offset, sizeof(position));
+        memcpy(&normal, v + layout.attribs[1].offset, sizeof(normal));
+        memcpy(uv, v + layout.attribs[2].offset, sizeof(uv));
+
+        const float *n = &hand.normals[i * 3];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; k++) {
+            positionError = max(positionError, (double)fabsf(position[k] - hand.positions[i * 3 + k]));
+            float expected = length > 0.0f ? n[k] / length : n[k];
+            normalError = max(normalError, (double)fabsf(unpackSnorm10((normal >> (10 * k)) & 0x3FFu) - expected));
+        }
+        for (int k = 0; k < 2; k++) {
+            float t = hand.texcoords[i * 2 + k];
+            if (unitUv) uvError = max(uvError, (double)fabsf(unpackUnorm16(uv[k]) - t));
+            else if (t != 0.0f) uvError = max(uvError, fabs((double)halfToFloat(uv[k]) - t) / fabs(t));
+        }
+    }
+    printf("  hand: %zu vertices, %u bytes each, uv as %s\n", vertexCount, layout.stride, unitUv ? "unorm16" : "half");
+    check("hand positions (float3)", positionError, 0.0);
+    check("hand normals (2_10_10_10)", normalError, SNORM10_BOUND);
+    check(unitUv ? "hand uv (unorm16)" : "hand uv (half, relative)", uvError, unitUv ? UNORM16_BOUND : HALF_RELATIVE_BOUND);
+    return failures;
+}
+
+// 壞掉的快取都要被拒絕（不能讓後面的程式讀到範圍外）：小 OBJ 寫出正確的快取後，改寫成各種不一致的版本
+int runMeshCacheSelfTest() {
+    string obj = "selftest_cache.obj";
+    {
+        ofstream f(obj);
+        f << "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\n" << "vt 0 0\nvt 1 0\nvt 0 1\nvt 1 1\n" << "vn 0 0 1\n"
+          << "f 1/1/1 2/2/1 3/3/1\nf 2/2/1 4/4/1 3/3/1\n";
+    }
+    ObjectLoadOptions options;
+    options.indexed = true;
+    options.useCache = true;
+    Object parsed(obj, options); // 快取不存在：解析後寫出
+
+    int failures = 0;
+    MeshCacheData good;
+    bool stale = false;
+    bool hit = readMeshCache(obj, MESH_CACHE_INDEXED, good, stale);
+    bool same = hit && good.positions == parsed.positions && good.normals == parsed.normals
+        && good.texcoords == parsed.texcoords && good.indices == parsed.indices;
+    printf("  %-44s %s\n", "valid cache", same ? "loaded, ok" : "FAIL");
+    if (!same) failures++;
+
+    struct Corruption
+    {
+        const char *name;
+        void (*apply)(MeshCacheData &mesh);
+    };
+    const Corruption corruptions[] = {
+        { "no normals", [](MeshCacheData &m) { m.normals.clear(); } },
+        { "no normals or uvs", [](MeshCacheData &m) { m.normals.clear(); m.texcoords.clear(); } },
+        { "one uv short", [](MeshCacheData &m) { m.texcoords.resize(m.texcoords.size() - 2); } },
+        { "index past the last vertex", [](MeshCacheData &m) { m.indices.back() = (unsigned int)(m.positions.size() / 3); } },
+        { "partial triangle", [](MeshCacheData &m) { m.indices.pop_back(); } },
+        { "indexed without indices", [](MeshCacheData &m) { m.indices.clear(); } },
+        { "partial vertex", [](MeshCacheData &m) { m.positions.pop_back(); } },
+    };
+    for (const Corruption &c : corruptions) {
+        MeshCacheData bad = good, out;
+        c.apply(bad);
+        bool accepted = writeMeshCache(obj, bad) && readMeshCache(obj, MESH_CACHE_INDEXED, out, stale);
+        printf("  %-44s %s\n", c.name, accepted ? "ACCEPTED" : "rejected, ok");
+        if (accepted) failures++;
+    }
+
+    // 計數大到 payload 的乘法會繞回原本的大小
+    MeshCacheData out;
+    writeMeshCache(obj, good);
+    {
+        fstream f(meshCachePath(obj), ios::in | ios::out | ios::binary);
+        uint64_t count = good.normals.size() + (1ULL << 62);
+        f.seekp(offsetof(MeshCacheHeader, normalCount));
+        f.write((const char *)&count, sizeof(count));
+    }
+    bool accepted = readMeshCache(obj, MESH_CACHE_INDEXED, out, stale);
+    printf("  %-44s %s\n", "normal count wrapping the payload size", accepted ? "ACCEPTED" : "rejected, ok");
+    if (accepted) failures++;
+
+    remove(meshCachePath(obj).c_str());
+    remove(obj.c_str());
+    return failures;
+}
+
+// 手模型的載入時間：解析 OBJ + 合併頂點 vs 讀 mmap 的 .meshcache，各跑三次取最快
+int runMeshCacheBench() {
+    string file = assetPath("female_hand.obj");
+    // 和 app 一樣開著快取載入一次：快取不存在或過期時由 Object 自己寫出
+    ObjectLoadOptions options;
+    options.indexed = true;
+    options.useCache = true;
+    Object(file, options);
+
+    options.useCache = false;
+    double parseBest = 1e30, cacheBest = 1e30, hashBest = 1e30;
+    for (int run = 0; run < 3; run++) {
+        auto start = chrono::steady_clock::now();
+        Object parsed(file, options);
+        parseBest = min(parseBest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+
+        MeshCacheData cached;
+        bool stale = false;
+        start = chrono::steady_clock::now();
+        bool hit = readMeshCache(file, MESH_CACHE_INDEXED, cached, stale);
+        cacheBest = min(cacheBest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        if (!hit || cached.positions != parsed.positions || cached.indices != parsed.indices) {
+            cout << "Mesh cache of " << file << " is missing or differs from a fresh parse" << endl;
+            return 1;
+        }
+        // mtime 變了（checkout、複製）時還要多算一次 OBJ 的雜湊
+        start = chrono::steady_clock::now();
+        hashFile(file);
+        hashBest = min(hashBest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        if (run == 2) printf("  %s: %zu vertices, %zu triangles\n", file.c_str(), parsed.positions.size() / 3, parsed.indices.size() / 3);
+    }
+    printf("  OBJ parse + weld:  %8.2f ms\n", parseBest * 1000.0);
+    printf("  mapped cache load: %8.2f ms  (+%.2f ms when the mtime changed and the hash is checked)\n",
+        cacheBest * 1000.0, hashBest * 1000.0);
+    return 0;
+}
+
+// 合成的 OBJ 網格：columns x rows 個方格、各切成兩個三角形，v/vt/vn 共用同一個索引，
+// 每 rowsPerGroup 列開一個新的 g（每個 shape 都會清一次 vertex cache）。回傳三角形數，失敗時為 0
+size_t writeSyntheticObj(const string &path, int columns, int rows, int rowsPerGroup) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) return 0;
+    fprintf(f, "# synthetic %dx%d grid\n", columns, rows);
+    for (int y = 0; y <= rows; y++) {
+        for (int x = 0; x <= columns; x++) {
+            float u = (float)x / columns, v = (float)y / rows;
+            fprintf(f, "v %.6f %.6f %.6f\n", u, v, 0.1f * sinf(u * 12.0f) * cosf(v * 9.0f));
+            fprintf(f, "vt %.6f %.6f\n", u, v);
+            fprintf(f, "vn %.6f %.6f %.6f\n", -1.2f * cosf(u * 12.0f) * cosf(v * 9.0f), 0.9f * sinf(u * 12.0f) * sinf(v * 9.0f), 1.0f);
+        }
+    }
+    for (int y = 0; y < rows; y++) {
+        if (y % rowsPerGroup == 0) fprintf(f, "g part%d\n", y / rowsPerGroup);
+        for (int x = 0; x < columns; x++) {
+            int a = y * (columns + 1) + x + 1, b = a + 1, c = a + columns + 1, d = c + 1;
+            fprintf(f, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, d, d, d);
+            fprintf(f, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, d, d, d, c, c, c);
+        }
+    }
+    bool ok = ferror(f) == 0;
+    ok = fclose(f) == 0 && ok;
+    return ok ? (size_t)columns * rows * 2 : 0;
+}
+
+// 兩次載入的 shape 是否完全相同
+bool sameShapes(const vector<tinyobj::shape_t> &a, const vector<tinyobj::shape_t> &b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        const tinyobj::mesh_t &x = a[i].mesh, &y = b[i].mesh;
+        if (a[i].name != b[i].name || x.positions != y.positions || x.normals != y.normals || x.texcoords != y.texcoords
+            || x.indices != y.indices || x.num_vertices != y.num_vertices || x.material_ids != y.material_ids) return false;
+    }
+    return true;
+}
+
+// 用 loader 載入 path 三次取最快的秒數，shapes 為最後一次的結果
+typedef bool (*ObjLoader)(vector<tinyobj::shape_t> &, vector<tinyobj::material_t> &, string &, const char *, const char *, bool);
+double timeObjLoad(ObjLoader loader, const string &path, vector<tinyobj::shape_t> &shapes) {
+    double best = 1e30;
+    for (int run = 0; run < 3; run++) {
+        vector<tinyobj::material_t> materials;
+        string err;
+        auto start = chrono::steady_clock::now();
+        bool ok = loader(shapes, materials, err, path.c_str(), NULL, true);
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        if (!ok) shapes.clear();
+    }
+    return best;
+}
+
+// vertex cache 的比較：同樣的 OBJ 分別用舊的 std::map（LoadObjMapCache）與 open addressing（LoadObj）載入，
+// 合成網格 10k / 100k / 1M 個三角形加上手模型；每個三角形的時間固定才是線性成長
+int runObjParseBench() {
+    int failures = 0;
+    const size_t targets[] = { 10000, 100000, 1000000, 0 };
+    for (size_t target : targets) {
+        string path;
+        size_t faces = 0;
+        if (target > 0) {
+            int columns = (int)sqrt(target / 2.0);
+            int rows = (int)(target / 2 / columns);
+            path = selfTestOptions.outDir + "/synthetic_" + to_string(target) + ".obj";
+            faces = writeSyntheticObj(path, columns, rows, max(1, rows / 8));
+            if (faces == 0) {
+                cout << "Failed to write " << path << endl;
+                return failures + 1;
+            }
+        } else {
+            path = assetPath("female_hand.obj");
+        }
+
+        vector<tinyobj::shape_t> mapShapes, hashShapes;
+        double mapTime = timeObjLoad(tinyobj::LoadObjMapCache, path, mapShapes);
+        double hashTime = timeObjLoad(tinyobj::LoadObj, path, hashShapes);
+        if (hashShapes.empty()) {
+            cout << "Failed to load " << path << endl;
+            failures++;
+            continue;
+        }
+        if (target == 0) {
+            for (const tinyobj::shape_t &shape : hashShapes) faces += shape.mesh.num_vertices.size();
+        }
+        bool same = sameShapes(mapShapes, hashShapes);
+        if (!same) failures++;
+        printf("  %-20s %8zu faces: std::map %8.2f ms (%4.0f ns/face)  hash %8.2f ms (%4.0f ns/face)  %s\n",
+            target > 0 ? "synthetic" : "female_hand.obj", faces, mapTime * 1000.0, mapTime * 1e9 / max<size_t>(faces, 1),
+            hashTime * 1000.0, hashTime * 1e9 / max<size_t>(faces, 1), same ? "identical" : "MISMATCH");
+        if (target > 0) remove(path.c_str());
+    }
+    return failures;
+}
+
+// 各種寫法混在一起的 OBJ：每個區塊 4 個 v / vt / vn，面輪流用 v/vt/vn、負的相對索引、v//vn、v/vt、只有 v，
+// 以及四邊形；中間穿插 g / o / usemtl、註解與空行。crlf 時每行以 \r\n 結尾
+bool writeMixedObj(const string &path, int blocks, bool crlf) {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) return false;
+    const char *eol = crlf ? "\r\n" : "\n";
+    for (int b = 0; b < blocks; b++) {
+        if (b % 97 == 0) fprintf(f, "g group%d%s", b / 97, eol);
+        if (b % 211 == 5) fprintf(f, "o object%d%s", b / 211, eol);
+        if (b % 53 == 7) fprintf(f, "usemtl mat%d%s", b % 3, eol);
+        if (b % 31 == 0) fprintf(f, "# block %d%s%s", b, eol, eol);
+        for (int k = 0; k < 4; k++) {
+            fprintf(f, "v %d.%03d %d.5 -%d.25%s", b, k * 7, k, b % 5, eol);
+            fprintf(f, "vt 0.%03d 0.%03d%s", (b * 13 + k) % 1000, (b * 7 + k * 3) % 1000, eol);
+            fprintf(f, "vn 0 %d 1%s", k, eol);
+        }
+        int a = b * 4 + 1; // 這個區塊第一個頂點的絕對索引
+        switch (b % 6) {
+            case 0: fprintf(f, "f %d/%d/%d %d/%d/%d %d/%d/%d%s", a, a, a, a + 1, a + 1, a + 1, a + 2, a + 2, a + 2, eol); break;
+            case 1: fprintf(f, "f -4/-4/-4 -3/-3/-3 -2/-2/-2 -1/-1/-1%s", eol); break;
+            case 2: fprintf(f, "f %d//%d %d//%d %d//%d%s", a, a, a + 2, a + 2, a + 3, a + 3, eol); break;
+            case 3: fprintf(f, "f %d/%d %d/%d %d/%d%s", a + 1, a + 1, a + 2, a + 2, a + 3, a + 3, eol); break;
+            case 4: fprintf(f, "f %d %d %d%s", a, a + 1, a + 3, eol); break;
+            case 5: fprintf(f, "f -4//-4 -3//-3 -1//-1%sf %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d%s", eol,
+                        a, a, a, a + 1, a + 1, a + 1, a + 2, a + 2, a + 2, a + 3, a + 3, a + 3, eol); break;
+        }
+    }
+    bool ok = ferror(f) == 0;
+    ok = fclose(f) == 0 && ok;
+    return ok;
+}
+
+// 平行載入必須和單執行緒 LoadObj 完全相同：混合寫法的 OBJ（LF 與 CRLF）與合成網格，
+// 執行緒數不同時 64 KB 以上的 chunk 切在不同的行上，涵蓋各種語句跨 chunk 邊界的情況
+int runObjParallelSelfTest() {
+    struct Fixture
+    {
+        string name;
+        string path;
+    };
+    vector<Fixture> fixtures = {
+        { "mixed, LF", selfTestOptions.outDir + "/selftest_mixed_lf.obj" },
+        { "mixed, CRLF", selfTestOptions.outDir + "/selftest_mixed_crlf.obj" },
+        { "grid", selfTestOptions.outDir + "/selftest_grid.obj" },
+    };
+    bool written = writeMixedObj(fixtures[0].path, 6000, false) && writeMixedObj(fixtures[1].path, 6000, true)
+        && writeSyntheticObj(fixtures[2].path, 150, 150, 20) > 0;
+    if (!written) {
+        cout << "Failed to write the fixtures to " << selfTestOptions.outDir << endl;
+        return 1;
+    }
+
+    int failures = 0;
+    const int threadCounts[] = { 1, 2, 3, 8 };
+    for (const Fixture &fixture : fixtures) {
+        vector<tinyobj::shape_t> serial;
+        vector<tinyobj::material_t> materials;
+        string err;
+        bool ok = tinyobj::LoadObj(serial, materials, err, fixture.path.c_str());
+        size_t faces = 0;
+        for (const tinyobj::shape_t &shape : serial) faces += shape.mesh.num_vertices.size();
+        ifstream in(fixture.path, ios::binary | ios::ate);
+        printf("  %-12s %5.0f KB, %3zu shapes, %6zu faces:", fixture.name.c_str(), in.tellg() / 1024.0, serial.size(), faces);
+        if (!ok || serial.empty()) {
+            printf(" serial load FAILED\n");
+            failures++;
+            continue;
+        }
+        for (int threads : threadCounts) {
+            vector<tinyobj::shape_t> parallel;
+            bool same = tinyobj::LoadObjParallel(parallel, materials, err, fixture.path.c_str(), NULL, true, threads)
+                && sameShapes(serial, parallel);
+            printf("  %d threads %s", threads, same ? "identical" : "MISMATCH");
+            if (!same) failures++;
+        }
+        printf("\n");
+    }
+    for (const Fixture &fixture : fixtures) remove(fixture.path.c_str());
+    return failures;
+}
+
+// 壓縮貼圖快取：RGB / RGBA 都要原樣讀回；欄位被改成不一致的快取都要被拒絕（上傳時會除以 0 或讀到範圍外）
+int runTextureCacheSelfTest() {
+    // 快取只會 stat 與 hash 來源檔，不會解碼它
+    string source = "selftest_texture.bin";
+    {
+        ofstream f(source, ios::binary);
+        f << "texture cache self-test source";
+    }
+
+    int failures = 0;
+    DecodedImage rgb;
+    const int channelCounts[] = { 3, 4 };
+    for (int channels : channelCounts) {
+        DecodedImage image;
+        image.channels = channels;
+        MipLevel base;
+        base.width = 37;
+        base.height = 21;
+        base.pixels.resize((size_t)base.width * base.height * channels);
+        for (size_t i = 0; i < base.pixels.size(); i++) base.pixels[i] = (unsigned char)(i * 7 + i / 111 * 13);
+        image.levels.push_back(move(base));
+        buildMipChain(image);
+        DecodedImage compressed = compressImage(image);
+
+        DecodedImage loaded;
+        bool stale = false;
+        bool same = writeTextureCache(source, compressed) && readTextureCache(source, loaded, stale)
+            && loaded.channels == channels && loaded.levels.size() == compressed.levels.size();
+        for (size_t l = 0; same && l < loaded.levels.size(); l++) {
+            same = loaded.levels[l].width == compressed.levels[l].width && loaded.levels[l].height == compressed.levels[l].height
+                && loaded.levels[l].pixels == compressed.levels[l].pixels;
+        }
+        printf("  %-44s %s\n", channels == 4 ? "valid cache, RGBA" : "valid cache, RGB", same ? "loaded, ok" : "FAIL");
+        if (!same) failures++;
+        if (channels == 3) rgb = move(compressed);
+    }
+
+    // 改寫 RGB 快取裡的一個欄位（4 或 8 bytes）
+    struct Patch
+    {
+        const char *name;
+        size_t offset;
+        uint64_t value;
+        size_t bytes;
+    };
+    const size_t level0 = sizeof(TextureCacheHeader);
+    const size_t level1 = level0 + sizeof(TextureCacheLevel) + rgb.levels[0].pixels.size();
+    const Patch patches[] = {
+        { "one channel", offsetof(TextureCacheHeader, channels), 1, 4 },
+        { "more levels than down to 1x1", offsetof(TextureCacheHeader, levelCount), 40, 4 },
+        { "level 0 height 0", level0 + offsetof(TextureCacheLevel, height), 0, 4 },
+        { "level 1 not half of level 0", level1 + offsetof(TextureCacheLevel, width), (uint64_t)rgb.levels[1].width + 1, 4 },
+        { "level 0 one block short", level0 + offsetof(TextureCacheLevel, size), rgb.levels[0].pixels.size() - 8, 8 },
+        { "level 0 size wrapping the offset", level0 + offsetof(TextureCacheLevel, size), ~0ULL, 8 },
+    };
+    for (const Patch &p : patches) {
+        writeTextureCache(source, rgb);
+        {
+            fstream f(textureCachePath(source), ios::in | ios::out | ios::binary);
+            uint32_t value32 = (uint32_t)p.value;
+            f.seekp(p.offset);
+            f.write(p.bytes == 4 ? (const char *)&value32 : (const char *)&p.value, p.bytes);
+        }
+        DecodedImage out;
+        bool stale = false;
+        bool accepted = readTextureCache(source, out, stale);
+        printf("  %-44s %s\n", p.name, accepted ? "ACCEPTED" : "rejected, ok");
+        if (accepted) failures++;
+    }
+
+    remove(textureCachePath(source).c_str());
+    remove(source.c_str());
+    return failures;
+}
+
+// RenderQueue 的排序檢查（不需要 OpenGL）：各種大小的隨機佇列，radix sort 排出的順序要和
+// 以同一個 key 做 stable_sort 完全相同、半透明層要由遠到近，並比較兩者的時間
+int runRenderQueueSelfTest() {
+    // 1 和 4097 的低 12 位元相同：key 衝突時仍要保持提交順序
+    ShaderProgram programs[3];
+    programs[0].id = 1; programs[1].id = 2; programs[2].id = 4097;
+    uint32_t seed = 12345;
+    auto random = [&seed](uint32_t range) {
+        seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+        return seed % range;
+    };
+
+    int failures = 0;
+    const size_t sizes[] = { 5, 64, 256, 1023, 1024, 4096, 100000 };
+    for (size_t n : sizes) {
+        RenderQueue queue;
+        vector<DrawItem> items(n);
+        for (DrawItem &item : items) {
+            item.layer = (RENDERLAYER)random(3);
+            item.program = &programs[random(3)];
+            item.texture = random(4);
+            item.vao = 1 + random(3);
+            item.depth = random(200) * 0.25f; // 重複的深度也要穩定
+            item.count = 3;
+            queue.submit(item);
+        }
+
+        double radixBest = 1e30, stableBest = 1e30;
+        vector<pair<uint64_t, uint32_t>> reference(n);
+        for (int run = 0; run < 5; run++) {
+            auto start = chrono::steady_clock::now();
+            queue.sort();
+            radixBest = min(radixBest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+            start = chrono::steady_clock::now();
+            for (size_t i = 0; i < n; i++) reference[i] = { RenderQueue::sortKey(items[i]), (uint32_t)i };
+            stable_sort(reference.begin(), reference.end(),
+                [](const pair<uint64_t, uint32_t> &a, const pair<uint64_t, uint32_t> &b) { return a.first < b.first; });
+            stableBest = min(stableBest, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+
+        vector<uint32_t> order = queue.drawOrder();
+        bool same = order.size() == n, backToFront = true;
+        for (size_t i = 0; same && i < n; i++) same = order[i] == reference[i].second;
+        for (size_t i = 1; i < order.size(); i++) {
+            const DrawItem &a = items[order[i - 1]], &b = items[order[i]];
+            if (a.layer > b.layer) backToFront = false;
+            if (a.layer == RENDERLAYER::TRANSLUCENT && b.layer == RENDERLAYER::TRANSLUCENT && a.depth < b.depth) backToFront = false;
+        }
+        if (!same || !backToFront) failures++;
+        printf("  %6zu items: queue %9.1f us (%s)  stable_sort %9.1f us  %s\n", n, radixBest * 1e6,
+            n < RenderQueue::RADIX_MIN_ITEMS ? "comparison sort" : (to_string(queue.sortPasses()) + " radix passes").c_str(),
+            stableBest * 1e6, !same ? "ORDER DIFFERS" : !backToFront ? "LAYERS OUT OF ORDER" : "same order");
+    }
+    return failures;
+}
+
+// CPU 木紋背景：每種 SIMD 與執行緒數量各跑三次取最快，並與純量版本比較結果
+int runBackgroundBench() {
+    int width = selfTestOptions.width, height = selfTestOptions.height;
+    int cores = max(1, (int)thread::hardware_concurrency());
+    double megapixels = width * (double)height / 1e6;
+    cout << "Wood background " << width << "x" << height << ", " << cores << " hardware threads" << endl;
+
+    vector<unsigned char> reference, pixels;
+    bakeWoodTexture(width, height, reference, 0, WOODSIMD::SCALAR);
+
+    const WOODSIMD levels[] = { WOODSIMD::SCALAR, WOODSIMD::SSE2, WOODSIMD::AVX2 };
+    for (WOODSIMD level : levels) {
+        if (resolveWoodSimd(level) != level) {
+            cout << "  " << woodSimdName(level) << ": not available" << endl;
+            continue;
+        }
+        for (int threads = 1; ; threads = min(threads * 2, cores)) {
+            double best = 1e30;
+            for (int run = 0; run < 3; run++) {
+                auto start = chrono::steady_clock::now();
+                bakeWoodTexture(width, height, pixels, threads, level);
+                best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+            }
+            int maxDiff = 0;
+            for (size_t i = 0; i < pixels.size(); i++) maxDiff = max(maxDiff, abs((int)pixels[i] - (int)reference[i]));
+            printf("  %-6s %2d threads: %8.2f ms  %8.2f MP/s  max diff vs scalar %d\n",
+                woodSimdName(level), threads, best * 1000.0, megapixels / best, maxDiff);
+            if (threads == cores) break;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    vector<string> names;
+    for (int i = 1; i < argc; i++) {
+        string name = argv[i];
+        if (name == "--out" && i + 1 < argc) {
+            selfTestOptions.outDir = argv[++i];
+            continue;
+        }
+        if (name == "--size" && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &selfTestOptions.width, &selfTestOptions.height) != 2
+                || selfTestOptions.width <= 0 || selfTestOptions.height <= 0) {
+                cout << "Invalid --size, expected WxH" << endl;
+                return -1;
+            }
+            continue;
+        }
+        bool known = false;
+        for (const SelfTest &t : selfTests) known = known || name == t.name;
+        if (!known) {
+            cout << "Usage: ICG_2025_HW2_selftest [--out DIR] [--size WxH] [NAME...]\n       NAME:";
+            for (const SelfTest &t : selfTests) cout << " " << t.name;
+            cout << endl;
+            return -1;
+        }
+        names.push_back(name);
+    }
+
+    int failed = 0;
+    for (const SelfTest &t : selfTests) {
+        bool wanted = names.empty() ? !t.benchmark : find(names.begin(), names.end(), t.name) != names.end();
+        if (!wanted) continue;
+        cout << "[" << t.name << "]" << endl;
+        int failures = t.run();
+        cout << "[" << t.name << "] " << (failures ? "FAILED" : "passed") << endl;
+        if (failures) failed++;
+    }
+    return failed ? 1 : 0;
+}
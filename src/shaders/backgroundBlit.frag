@@ -0,0 +1,9 @@
+#version 330 core
+out vec4 FragColor;
+
+// 預先畫好的木紋（BackgroundCache），大小與畫面相同，逐像素直接複製
+uniform sampler2D backgroundTexture;
+
+void main() {
+    FragColor = texelFetch(backgroundTexture, ivec2(gl_FragCoord.xy), 0);
+}
@@ -2,7 +2,15 @@
 out vec4 FragColor;
 in vec2 TexCoord;
 
-uniform float time;
+// 每幀共用資料（與 FrameData.h 對應）
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    float time;
+    int activeFinger;
+    float patternProgress;
+    int fingerPainted[6];
+};
 
 float noise(vec2 p) {
     return fract(sin(dot(p, vec2(127.1, 311.7))) * 43758.5453);
@@ -0,0 +1,116 @@
+#version 330 core
+// 樣板網格（見 Decorations.h 的 templateMesh）
+layout (location = 0) in vec3 aShape;
+layout (location = 1) in vec3 aShapeNormal;
+// 每個裝飾一筆（DecorationInstance）
+layout (location = 2) in vec4 iCenterSeed;
+layout (location = 3) in vec4 iNormal;
+layout (location = 4) in vec4 iAxisA;
+layout (location = 5) in vec4 iAxisB;
+
+out vec2 gTexCoord;
+out vec3 gRawPos;
+out vec3 gNormal;
+out float isPattern;
+out float shouldColor;
+flat out int gTag;
+
+uniform mat4 mvp;   // projection * view * model，每幀在 CPU 算好
+uniform int decorKind;       // 1 = 鑽石, 2 = 金字塔, 3 = 星星
+uniform float decorProgress; // 已完成時為 1.0
+uniform int decorFinished;
+
+// 每幀共用資料（與 FrameData.h 對應）
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    float time;
+    int activeFinger;
+    float patternProgress;
+    int fingerPainted[6];
+};
+
+// 大拇指 (1) - 立體鑽石：底面半徑與高度隨進度增長
+void diamond(vec3 center, vec3 normal, vec3 tangent, vec3 bitangent, out vec3 pos, out vec3 norm) {
+    float radius = iAxisA.w * decorProgress;
+    float height = iAxisB.w * decorProgress;
+    pos = center + (tangent * aShape.x + bitangent * aShape.y) * radius + normal * aShape.z * height;
+    // 單位圓錐的面法向量經過非等比縮放後需除以縮放量
+    vec3 n = aShapeNormal / vec3(max(radius, 1e-6), max(radius, 1e-6), max(height, 1e-6));
+    norm = normalize(tangent * n.x + bitangent * n.y + normal * n.z);
+}
+
+// 食指 (2) - 爆炸金字塔：三角形沿法線飛出並旋轉，再長出頂點
+void explodingPyramid(vec3 center, vec3 normal, float seed, out vec3 pos, out vec3 norm) {
+    float t = decorProgress;
+    // 爆炸強度：前半段增加，後半段減少
+    float explosionIntensity = (t < 0.5) ? (t * 2.0) : (1.0 - (t - 0.5) * 2.0);
+    float displacement = explosionIntensity * 1.0 * seed;
+    float rotationAngle = explosionIntensity * 6.28318 * seed * 1.5;
+
+    vec3 v0 = center + iAxisA.xyz;
+    vec3 v1 = center + iAxisB.xyz;
+    vec3 v2 = center - iAxisA.xyz - iAxisB.xyz;
+
+    vec3 tangent = normalize(v1 - v0);
+    vec3 bitangent = normalize(cross(normal, tangent));
+    vec3 explosionDir = normalize(normal + tangent * (seed - 0.5) * 0.6 + bitangent * (fract(seed * 7.13) - 0.5) * 0.6);
+    vec3 nCenter = center + explosionDir * displacement;
+
+    float cosA = cos(rotationAngle);
+    float sinA = sin(rotationAngle);
+    vec3 p[4];
+    p[0] = nCenter + (v0 - center) * cosA + cross(normal, v0 - center) * sinA;
+    p[1] = nCenter + (v1 - center) * cosA + cross(normal, v1 - center) * sinA;
+    p[2] = nCenter + (v2 - center) * cosA + cross(normal, v2 - center) * sinA;
+    p[3] = nCenter + normal * mix(0.15, 0.3, fract(seed * 3.7));
+
+    // 四個面：(0,1,頂) (1,2,頂) (2,0,頂) 與底面
+    int corner = int(aShape.x + 0.5);
+    int face = int(aShape.y + 0.5);
+    pos = p[corner];
+    if (face == 3) {
+        norm = -normal;
+    } else {
+        vec3 a = p[face];
+        vec3 b = p[(face + 1) % 3];
+        norm = normalize(cross(b - a, p[3] - a));
+    }
+}
+
+// 中指 (3) - 旋轉星星：完成後慢速旋轉，生長中快速旋轉
+void rotatingStar(vec3 center, vec3 normal, vec3 tangent, vec3 bitangent, float seed, out vec3 pos, out vec3 norm) {
+    bool isFinished = decorFinished != 0;
+    float speedMultiplier = isFinished ? 0.5 : 2.0;
+    float rotationSpeed = time * speedMultiplier + seed * 6.28318;
+    float size = iAxisA.w;
+    float currentSize = isFinished ? size : size * min(decorProgress * 1.5, 1.0);
+
+    float angle = aShape.x + rotationSpeed;
+    float radius = aShape.y * currentSize;
+    pos = center + (tangent * cos(angle) + bitangent * sin(angle)) * radius + normal * aShape.z;
+    norm = normal;
+}
+
+void main() {
+    vec3 center = iCenterSeed.xyz;
+    float seed = iCenterSeed.w;
+    vec3 normal = iNormal.xyz;
+
+    vec3 pos, norm;
+    if (decorKind == 1) {
+        diamond(center, normal, iAxisA.xyz, iAxisB.xyz, pos, norm);
+    } else if (decorKind == 2) {
+        explodingPyramid(center, normal, seed, pos, norm);
+    } else {
+        rotatingStar(center, normal, iAxisA.xyz, iAxisB.xyz, seed, pos, norm);
+    }
+
+    gTexCoord = vec2(0.0);
+    gRawPos = pos;
+    gNormal = norm;
+    isPattern = float(decorKind);
+    shouldColor = 1.0;
+    gTag = 0;
+    gl_Position = mvp * vec4(pos, 1.0);
+}
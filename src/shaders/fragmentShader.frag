@@ -6,11 +6,19 @@ in vec3 gRawPos;
 in vec3 gNormal;
 in float isPattern;
 in float shouldColor;
+flat in int gTag;   // 手指 (bit 0-2) + 指甲裝飾帶 (bit 3)，載入時計算一次
 
 uniform sampler2D handTexture;
-uniform int activeFinger;
-uniform float patternProgress;
-uniform int fingerPainted[6];
+
+// 每幀共用資料（與 FrameData.h 對應）
+layout (std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    float time;
+    int activeFinger;
+    float patternProgress;
+    int fingerPainted[6];
+};
 
 // 設定每根手指的指甲底色
 vec3 getNailColor(int idx) {
@@ -22,26 +30,6 @@ vec3 getNailColor(int idx) {
     else return vec3(0.85, 0.85, 0.92);               // 預設
 }
 
-// 根據 UV 座標判斷手指索引
-int getFingerIndex(vec2 uv) {
-    if (uv.y < 0.1) {  // 指甲區域
-        if (uv.x < 0.5) {  // 左手
-            if (uv.x < 0.1) return 5;      // 小拇指
-            else if (uv.x < 0.2) return 4; // 無名指
-            else if (uv.x < 0.3) return 3; // 中指
-            else if (uv.x < 0.4) return 2; // 食指
-            else return 1;                  // 大拇指
-        } else {  // 右手
-            if (uv.x < 0.6) return 1;      // 大拇指
-            else if (uv.x < 0.7) return 2; // 食指
-            else if (uv.x < 0.8) return 3; // 中指
-            else if (uv.x < 0.9) return 4; // 無名指
-            else return 5;                  // 小拇指
-        }
-    }
-    return 0;  // 手掌
-}
-
 void main() {
     // === 1. 處理 3D 裝飾幾何體（從 geometry shader 生成） ===
     if (isPattern > 0.5) {
@@ -95,7 +83,7 @@ void main() {
     // === 2. 處理指甲彩繪（底色和特殊效果） ===
     vec4 texColor = texture(handTexture, gTexCoord);
     vec3 finalColor = texColor.rgb;
-    int fIdx = getFingerIndex(gTexCoord);
+    int fIdx = gTag & 7;
     
     if (fIdx > 0) {
         // 判斷該手指是否需要上色
@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in int aTag;   // 手指 (bit 0-2) + 指甲裝飾帶 (bit 3)，見 HandRegions.h
+
+// 直接輸出給 fragmentShader.frag（不經過 geometry shader）
+out vec2 gTexCoord;
+out vec3 gRawPos;
+out vec3 gNormal;
+out float isPattern;
+out float shouldColor;
+flat out int gTag;
+
+uniform mat4 mvp;   // projection * view * model，每幀在 CPU 算好
+
+void main() {
+    gTexCoord = aTexCoord;
+    gRawPos = aPos;
+    gNormal = aNormal;
+    isPattern = 0.0;
+    shouldColor = 1.0;
+    gTag = aTag;
+    gl_Position = mvp * vec4(aPos, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 gTexCoord;
+
+uniform sampler2D handTexture;
+
+// 皮膚與未上色的指甲：只取貼圖顏色（不需要判斷手指）
+void main() {
+    FragColor = texture(handTexture, gTexCoord);
+}
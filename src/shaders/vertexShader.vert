@@ -2,18 +2,19 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in int aTag;   // 手指 (bit 0-2) + 指甲裝飾帶 (bit 3)，見 HandRegions.h
 
 out vec2 TexCoord;
 out vec3 RawPos;
 out vec3 Normal;
+flat out int Tag;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform mat4 mvp;   // projection * view * model，每幀在 CPU 算好
 
 void main() {
     TexCoord = aTexCoord;
     RawPos = aPos;
     Normal = aNormal;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    Tag = aTag;
+    gl_Position = mvp * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,2 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "./header/stb_image_write.h"
\ No newline at end of file